@@ -0,0 +1,326 @@
+/* arena: plays engine against engine on all cores and reports the result with Elo and SPRT statistics */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <mutex>
+#include "brain.h"
+
+#define MAXOPENINGS 100000          // openings read from a book
+#define MAXOPENINGMOVES 32          // stones of one opening
+#define ARENATRANSSIZE 200003       // transposition table of each engine, small as there are many of them
+
+/***********************************************************************************************/
+
+struct EngineConfig {               // how one engine of the match searches
+	int moveTime;                   // ms per move, 0 for no limit
+	unsigned long long nodes;       // nodes per move and thread, 0 for no limit
+	int threads;
+	const char* weights;            // file with the values of the blocks, NULL for the built-in ones
+};
+
+struct Opening {
+	int length;
+	Field::Cell moves[MAXOPENINGMOVES];  // crosses and circles alternating, a cross first
+};
+
+/***********************************************************************************************/
+
+class Arena {
+	EngineConfig engines[2];        // A and B
+	int games;
+	int workers;
+	int randomMoves;                // stones of a random opening
+	unsigned long long seed;
+	Opening* book;
+	int bookSize;
+	bool sprt;
+	double elo0, elo1, alpha, beta; // the SPRT hypotheses and error rates
+	std::atomic<int> nextGame;
+	std::atomic<bool> stopped;      // set by the SPRT when it has decided
+	std::mutex lock;                // guards the counts and the output
+	int wins, draws, losses;        // seen by A
+	RecordWriter* records;          // the games played, NULL if they are not kept
+	void makeOpening(int pair, Opening* opening);
+	/* 1 if A wins, 0 for a draw, -1 if B wins; the moves are added to record unless it is NULL */
+	int playGame(Brain** brains, Field* field, int game, GameRecord* record);
+	void worker();
+	void report(bool final);
+public:
+	Arena();
+	~Arena();
+	bool parse(int argc, char** argv);
+	bool loadBook(const char* fileName);
+	bool openRecords(const char* fileName);
+	void run();
+};
+
+/***********************************************************************************************/
+
+Arena::Arena() {
+	for (int e = 0; e < 2; e++) {
+		engines[e].moveTime = 100;
+		engines[e].nodes = 0;
+		engines[e].threads = 1;
+		engines[e].weights = NULL;
+	}
+	games = 100;
+	workers = std::thread::hardware_concurrency();
+	if (workers < 1) workers = 1;
+	randomMoves = 2;
+	seed = (unsigned long long) time(NULL);
+	book = NULL;
+	bookSize = 0;
+	sprt = false;
+	elo0 = 0;
+	elo1 = 10;
+	alpha = 0.05;
+	beta = 0.05;
+	wins = draws = losses = 0;
+	records = NULL;
+}
+
+Arena::~Arena() {
+	delete[] book;
+	delete records;
+}
+
+bool Arena::parse(int argc, char** argv) {
+	for (int k = 1; k < argc; k++) {
+		const char* arg = argv[k];
+		const char* value = (k + 1 < argc) ? argv[k + 1] : NULL;
+		int e = (strlen(arg) > 2 && arg[strlen(arg) - 1] == 'b' && arg[strlen(arg) - 2] == '-') ? 1 : 0;
+		if (!strcmp(arg, "-sprt") && k + 2 < argc) {
+			sprt = true;
+			elo0 = atof(argv[++k]);
+			elo1 = atof(argv[++k]);
+			continue;
+		}
+		if (!value) return false;
+		k++;
+		if (!strcmp(arg, "-games")) games = atoi(value);
+		else if (!strcmp(arg, "-workers")) workers = atoi(value) > 0 ? atoi(value) : 1;
+		else if (!strcmp(arg, "-random")) randomMoves = atoi(value);
+		else if (!strcmp(arg, "-seed")) seed = strtoull(value, NULL, 10);
+		else if (!strcmp(arg, "-book")) {
+			if (!loadBook(value)) return false;
+		} else if (!strcmp(arg, "-records")) {
+			if (!openRecords(value)) return false;
+		} else if (!strcmp(arg, "-time") || !strcmp(arg, "-time-a") || !strcmp(arg, "-time-b")) {
+			for (int x = 0; x < 2; x++)
+				if (!strcmp(arg, "-time") || x == e) engines[x].moveTime = atoi(value);
+		} else if (!strcmp(arg, "-nodes") || !strcmp(arg, "-nodes-a") || !strcmp(arg, "-nodes-b")) {
+			for (int x = 0; x < 2; x++)
+				if (!strcmp(arg, "-nodes") || x == e) engines[x].nodes = strtoull(value, NULL, 10);
+		} else if (!strcmp(arg, "-threads") || !strcmp(arg, "-threads-a") || !strcmp(arg, "-threads-b")) {
+			for (int x = 0; x < 2; x++)
+				if (!strcmp(arg, "-threads") || x == e) engines[x].threads = atoi(value);
+		} else if (!strcmp(arg, "-weights") || !strcmp(arg, "-weights-a") || !strcmp(arg, "-weights-b")) {
+			Evaluation* evaluation = new Evaluation();
+			bool valid = evaluation->load(value);
+			delete evaluation;
+			if (!valid) return false;
+			for (int x = 0; x < 2; x++)
+				if (!strcmp(arg, "-weights") || x == e) engines[x].weights = value;
+		} else return false;
+	}
+	if (randomMoves > MAXOPENINGMOVES) randomMoves = MAXOPENINGMOVES;
+	for (int e = 0; e < 2; e++)
+		if (!engines[e].moveTime && !engines[e].nodes) return false;  // a search has to end
+	return games > 0;
+}
+
+/* one opening per line, "i,j" for every stone, a cross first */
+bool Arena::loadBook(const char* fileName) {
+	FILE* f = fopen(fileName, "r");
+	if (!f) return false;
+	if (!book) book = new Opening[MAXOPENINGS];
+	char line[1024];
+	while (bookSize < MAXOPENINGS && fgets(line, sizeof(line), f)) {
+		Opening* opening = &book[bookSize];
+		opening->length = 0;
+		const char* s = line;
+		int i, j, n;
+		while (opening->length < MAXOPENINGMOVES && sscanf(s, "%d,%d%n", &i, &j, &n) == 2) {
+			if (i < 0 || i >= NUMCOLS || j < 0 || j >= NUMROWS) break;
+			opening->moves[opening->length].i = i;
+			opening->moves[opening->length].j = j;
+			opening->length++;
+			s += n;
+		}
+		if (opening->length) bookSize++;
+	}
+	fclose(f);
+	return bookSize > 0;
+}
+
+bool Arena::openRecords(const char* fileName) {
+	if (!records) records = new RecordWriter();
+	if (records->open(fileName)) return true;
+	printf("%s is not a game record file or ends with an incomplete game\n", fileName);
+	return false;
+}
+
+void Arena::makeOpening(int pair, Opening* opening) {
+	if (bookSize) {
+		*opening = book[pair % bookSize];
+		return;
+	}
+	// random stones in the middle of the field, the same for both games of a pair
+	unsigned long long state = seed ^ (0x9e3779b97f4a7c15ULL * (pair + 1));
+	opening->length = 0;
+	while (opening->length < randomMoves) {
+		int i = NUMCOLS/2 - 3 + (int) (splitMix64(&state) % 7);
+		int j = NUMROWS/2 - 3 + (int) (splitMix64(&state) % 7);
+		bool taken = false;
+		for (int m = 0; m < opening->length; m++)
+			if (opening->moves[m].i == i && opening->moves[m].j == j) taken = true;
+		if (taken) continue;
+		opening->moves[opening->length].i = i;
+		opening->moves[opening->length].j = j;
+		opening->length++;
+	}
+}
+
+int Arena::playGame(Brain** brains, Field* field, int game, GameRecord* record) {
+	Opening opening;
+	makeOpening(game / 2, &opening);
+	for (int i = 0; i < NUMCOLS; i++)
+		for (int j = 0; j < NUMROWS; j++)
+			field->set(i, j, 0);
+	// the choices of the engines among the root moves follow the seed and the game, the tables start empty
+	for (int e = 0; e < 2; e++)
+		brains[e]->setSeed(seed ^ (0xbf58476d1ce4e5b9ULL * (2*game + e + 1)));
+	// A plays the crosses in even games, the pair plays the opening once from each side
+	int crossEngine = game % 2;
+	if (record) {
+		RecordEngine config[2];
+		for (int e = 0; e < 2; e++) {
+			config[e].moveTime = engines[e].moveTime;
+			config[e].nodes = engines[e].nodes < UINT_MAX ? (unsigned) engines[e].nodes : UINT_MAX;
+			config[e].threads = (unsigned short) engines[e].threads;
+			config[e].depth = 0;
+		}
+		record->start(NUMCOLS, NUMROWS, CROSS, &config[crossEngine], &config[1 - crossEngine], true);
+	}
+	int player = CROSS;
+	for (int m = 0; m < opening.length; m++) {
+		field->set(opening.moves[m].i, opening.moves[m].j, player);
+		if (record) record->add(opening.moves[m].i, opening.moves[m].j);
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+	int result = 0;
+	while (!brains[0]->isDraw()) {
+		int e = (player == CROSS) ? crossEngine : 1 - crossEngine;
+		int i, j;
+		brains[e]->startSearch(player, engines[e].moveTime);
+		brains[e]->waitSearch(&i, &j);
+		field->set(i, j, player);
+		if (record) {
+			SearchInfo info;
+			brains[e]->getSearchInfo(&info);
+			record->add(i, j, info.price, info.depth);
+		}
+		if (field->isFive(player, i, j, NULL, NULL, NULL)) {
+			result = (e == 0) ? 1 : -1;
+			break;
+		}
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+	if (record) {
+		record->finish(result ? player : RECORDDRAW);
+		records->write(record);
+	}
+	return result;
+}
+
+void Arena::worker() {
+	Field* field = new Field();
+	Brain* brains[2];
+	GameRecord* record = records ? new GameRecord() : NULL;
+	for (int e = 0; e < 2; e++) {
+		brains[e] = new Brain(field, ARENATRANSSIZE);
+		brains[e]->setThreads(engines[e].threads);
+		brains[e]->setNodeLimit(engines[e].nodes);
+		if (engines[e].weights) brains[e]->setWeights(engines[e].weights);
+	}
+	for (int game = nextGame++; game < games && !stopped; game = nextGame++) {
+		int result = playGame(brains, field, game, record);
+		lock.lock();
+		if (result > 0) wins++;
+		else if (result < 0) losses++;
+		else draws++;
+		report(false);
+		lock.unlock();
+	}
+	for (int e = 0; e < 2; e++)
+		delete brains[e];
+	delete record;
+	delete field;
+}
+
+/* Elo difference giving the expected score */
+double elo(double score) {
+	if (score <= 0) return -999;
+	if (score >= 1) return 999;
+	return -400 * log10(1 / score - 1);
+}
+
+/* Elo from the score, its 95% interval, the likelihood of superiority and the SPRT log-likelihood ratio */
+void Arena::report(bool final) {
+	int n = wins + draws + losses;
+	if (!n) return;
+	double score = (wins + 0.5*draws) / n;
+	double variance = (wins*(1 - score)*(1 - score) + draws*(0.5 - score)*(0.5 - score) + losses*score*score) / n;
+	double margin = 1.96 * sqrt(variance / n);
+	double low = score - margin, high = score + margin;
+	double los = (wins + losses) ? 0.5 * (1 + erf((wins - losses) / sqrt(2.0 * (wins + losses)))) : 0.5;
+	printf("%s%d games: +%d =%d -%d  score %.3f  elo %+.1f [%+.1f, %+.1f]  los %.1f%%",
+		final ? "final " : "", n, wins, draws, losses, score, elo(score), elo(low), elo(high), 100 * los);
+	if (sprt) {
+		double s0 = 1 / (1 + pow(10, -elo0 / 400));
+		double s1 = 1 / (1 + pow(10, -elo1 / 400));
+		double llr = variance > 0 ? n * (s1 - s0) * (2*score - s0 - s1) / (2 * variance) : 0;
+		double lower = log(beta / (1 - alpha));
+		double upper = log((1 - beta) / alpha);
+		printf("  llr %.2f [%.2f, %.2f]", llr, lower, upper);
+		if (llr >= upper || llr <= lower) {
+			if (!stopped) printf("  %s accepted", llr >= upper ? "H1" : "H0");
+			stopped = true;
+		}
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+void Arena::run() {
+	printf("A: time %d nodes %llu threads %d, B: time %d nodes %llu threads %d, %d games on %d workers\n",
+		engines[0].moveTime, engines[0].nodes, engines[0].threads,
+		engines[1].moveTime, engines[1].nodes, engines[1].threads, games, workers);
+	nextGame = 0;
+	stopped = false;
+	std::thread* threads = new std::thread[workers];
+	for (int w = 0; w < workers; w++)
+		threads[w] = std::thread(&Arena::worker, this);
+	for (int w = 0; w < workers; w++)
+		threads[w].join();
+	delete[] threads;
+	report(true);
+	if (records && !records->close()) printf("the game records could not be written\n");
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Arena* arena = new Arena();
+	if (!arena->parse(argc, argv)) {
+		printf("usage: arena [-games n] [-workers n] [-time[-a|-b] ms] [-nodes[-a|-b] n] [-threads[-a|-b] n]\n"
+			"             [-weights[-a|-b] file] [-random stones | -book file] [-records file] [-seed n]\n"
+			"             [-sprt elo0 elo1]\n");
+		delete arena;
+		return 1;
+	}
+	arena->run();
+	delete arena;
+	return 0;
+}
@@ -0,0 +1,201 @@
+/* bench: searches a fixed suite of positions to a fixed depth and for a fixed time and reports the speed
+   of the engine; the node counts of the fixed depth runs are repeatable and their sum is the signature */
+
+#include <stdio.h>
+#include <string.h>
+#include "brain.h"
+
+#define BENCHDEPTH 6                // default depth of the fixed depth runs
+#define BENCHTIME 1000              // default ms of the fixed time runs
+#define BENCHSEED 12345             // zobrist codes and evaluation noise of every run
+#define BENCHTRANSSIZE 1000003
+
+/***********************************************************************************************/
+
+/* "i,j,item" for every stone, the player to move is the one with fewer stones (a cross first) */
+static const char* suite[] = {
+	"9,9,2 10,10,1",
+	"9,9,2 10,10,1 10,9,2 8,9,1 11,8,2 9,10,1",
+	"9,9,2 10,10,1 10,9,2 8,9,1 11,8,2 9,10,1 11,10,2 12,11,1",
+	"5,5,1 6,6,2 6,5,1 7,5,2 7,6,1 5,7,2 8,7,1 4,4,2 8,8,1 9,9,2",
+	"10,10,1 11,11,2 10,11,1 10,12,2 11,10,1 9,10,2 12,9,1 13,8,2 12,10,1 13,10,2 12,12,1 12,11,2",
+	"3,15,2 4,14,1 4,15,2 5,15,1 5,14,2 6,13,1 3,14,2 3,13,1 2,14,2 6,16,1 1,14,2 0,14,1",
+	"9,9,2 10,10,1 9,10,2 9,11,1 10,9,2 8,9,1 11,9,2 12,9,1 10,8,2 11,7,1 8,10,2 7,11,1 10,11,2 11,12,1",
+	"8,8,1 9,9,2 8,9,1 8,10,2 9,8,1 7,8,2 10,7,1 11,6,2 10,8,1 11,8,2 10,10,1 9,10,2 7,10,1 10,9,2",
+};
+
+#define NUMPOSITIONS ((int) (sizeof(suite) / sizeof(suite[0])))
+
+struct BenchResult {                // one search of one position
+	int i, j;                       // chosen move
+	int price;
+	int depth;                      // deepest finished iteration
+	unsigned long long nodes;
+	unsigned long long tableProbes, tableHits;
+	int time;                       // ms
+	int depthTime[MAXDEPTH+1];      // us, -1 if not reached
+};
+
+/***********************************************************************************************/
+
+class Bench {
+	Field* field;
+	Brain* brain;
+	int depth;
+	int moveTime;
+	BenchResult fixedDepth[NUMPOSITIONS];
+	BenchResult fixedTime[NUMPOSITIONS];
+	int load(int p);                // sets up the position, returns the player to move
+	void searchPosition(int p, int player, int moveTime, BenchResult* result);
+	void print(const char* title, BenchResult* results);
+	void writeRun(FILE* f, const char* name, BenchResult* results);
+public:
+	Bench(int depth, int moveTime);
+	~Bench();
+	unsigned long long run();       // returns the signature
+	bool writeJson(const char* fileName, unsigned long long signature);
+};
+
+/***********************************************************************************************/
+
+Bench::Bench(int depth, int moveTime) {
+	this->depth = depth;
+	this->moveTime = moveTime;
+	field = new Field();
+	brain = new Brain(field, BENCHTRANSSIZE);
+	brain->setThreads(1);           // more threads would make the node counts differ from run to run
+}
+
+Bench::~Bench() {
+	delete brain;
+	delete field;
+}
+
+int Bench::load(int p) {
+	for (int i = 0; i < NUMCOLS; i++)
+		for (int j = 0; j < NUMROWS; j++)
+			field->set(i, j, 0);
+	const char* s = suite[p];
+	int i, j, item, n, stones = 0;
+	while (sscanf(s, "%d,%d,%d%n", &i, &j, &item, &n) == 3) {
+		field->set(i, j, item);
+		s += n;
+		stones++;
+	}
+	return (stones % 2) ? CIRCLE : CROSS;
+}
+
+void Bench::searchPosition(int p, int player, int moveTime, BenchResult* result) {
+	load(p);
+	brain->setSeed(BENCHSEED);      // also clears the transposition table
+	brain->initTransTable();
+	brain->startSearch(player, moveTime);
+	brain->waitSearch(&result->i, &result->j);
+	SearchInfo info;
+	brain->getSearchInfo(&info);
+	result->price = info.price;
+	result->depth = info.depth;
+	result->nodes = info.nodes;
+	result->tableProbes = info.tableProbes;
+	result->tableHits = info.tableHits;
+	result->time = info.time;
+	memcpy(result->depthTime, info.depthTime, sizeof(result->depthTime));
+}
+
+unsigned long long Bench::run() {
+	unsigned long long signature = 0;
+	brain->setDepthLimit(depth);
+	for (int p = 0; p < NUMPOSITIONS; p++) {
+		searchPosition(p, load(p), 0, &fixedDepth[p]);
+		signature += fixedDepth[p].nodes;
+	}
+	print("fixed depth", fixedDepth);
+	brain->setDepthLimit(0);
+	for (int p = 0; p < NUMPOSITIONS; p++)
+		searchPosition(p, load(p), moveTime, &fixedTime[p]);
+	print("fixed time", fixedTime);
+	return signature;
+}
+
+void Bench::print(const char* title, BenchResult* results) {
+	unsigned long long nodes = 0;
+	long long time = 0;
+	printf("%s\n", title);
+	printf("pos  move    price depth      nodes  time ms       nps  hits %%  time to depth ms\n");
+	for (int p = 0; p < NUMPOSITIONS; p++) {
+		BenchResult* r = &results[p];
+		printf("%3d %2d,%-2d %8d %5d %10llu %8d %9llu %7.1f ", p, r->i, r->j, r->price, r->depth, r->nodes, r->time,
+			r->time ? r->nodes * 1000 / r->time : 0, r->tableProbes ? 100.0 * r->tableHits / r->tableProbes : 0.0);
+		for (int d = 1; d <= MAXDEPTH && r->depthTime[d] >= 0; d++)
+			printf(" %d", r->depthTime[d] / 1000);
+		printf("\n");
+		nodes += r->nodes;
+		time += r->time;
+	}
+	printf("total %llu nodes %lld ms %llu nps\n\n", nodes, time, time ? nodes * 1000 / time : 0);
+}
+
+void Bench::writeRun(FILE* f, const char* name, BenchResult* results) {
+	fprintf(f, "  \"%s\": [\n", name);
+	for (int p = 0; p < NUMPOSITIONS; p++) {
+		BenchResult* r = &results[p];
+		fprintf(f, "    {\"position\": %d, \"move\": [%d, %d], \"price\": %d, \"depth\": %d, \"nodes\": %llu, "
+			"\"time_ms\": %d, \"nps\": %llu, \"table_probes\": %llu, \"table_hits\": %llu, \"depth_time_us\": [",
+			p, r->i, r->j, r->price, r->depth, r->nodes, r->time, r->time ? r->nodes * 1000 / r->time : 0,
+			r->tableProbes, r->tableHits);
+		for (int d = 1; d <= MAXDEPTH && r->depthTime[d] >= 0; d++)
+			fprintf(f, "%s%d", d > 1 ? ", " : "", r->depthTime[d]);
+		fprintf(f, "]}%s\n", p + 1 < NUMPOSITIONS ? "," : "");
+	}
+	fprintf(f, "  ]");
+}
+
+bool Bench::writeJson(const char* fileName, unsigned long long signature) {
+	FILE* f = fopen(fileName, "w");
+	if (!f) return false;
+	fprintf(f, "{\n  \"depth\": %d,\n  \"time_ms\": %d,\n  \"signature\": %llu,\n", depth, moveTime, signature);
+	writeRun(f, "fixed_depth", fixedDepth);
+	fprintf(f, ",\n");
+	writeRun(f, "fixed_time", fixedTime);
+	fprintf(f, "\n}\n");
+	fclose(f);
+	return true;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	int depth = BENCHDEPTH;
+	int moveTime = BENCHTIME;
+	const char* json = NULL;
+	unsigned long long expected = 0;
+	bool check = false;
+	for (int k = 1; k < argc; k++) {
+		if (k + 1 >= argc) depth = 0;   // every option has a value
+		else if (!strcmp(argv[k], "-depth")) depth = atoi(argv[++k]);
+		else if (!strcmp(argv[k], "-time")) moveTime = atoi(argv[++k]);
+		else if (!strcmp(argv[k], "-json")) json = argv[++k];
+		else if (!strcmp(argv[k], "-check")) {
+			check = true;
+			expected = strtoull(argv[++k], NULL, 10);
+		} else depth = 0;
+		if (depth < 1 || depth > MAXDEPTH || moveTime < 1) {
+			printf("usage: bench [-depth d] [-time ms] [-json file] [-check signature]\n");
+			return 1;
+		}
+	}
+	Bench* bench = new Bench(depth, moveTime);
+	unsigned long long signature = bench->run();
+	printf("signature %llu\n", signature);
+	int status = 0;
+	if (json && !bench->writeJson(json, signature)) {
+		printf("cannot write %s\n", json);
+		status = 1;
+	}
+	if (check && signature != expected) {
+		printf("signature mismatch, expected %llu\n", expected);
+		status = 1;
+	}
+	delete bench;
+	return status;
+}
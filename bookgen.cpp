@@ -0,0 +1,292 @@
+/* bookgen: builds an opening book from games of self-play on all cores or from game records */
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include "brain.h"
+
+#define BOOKTRANSSIZE 200003        // transposition table of each engine
+#define MAXGAMELENGTH (NUMCOLS*NUMROWS)
+
+/***********************************************************************************************/
+
+struct Game {
+	int length;
+	Field::Cell moves[MAXGAMELENGTH];  // crosses and circles alternating, a cross first
+	int winner;                     // CROSS, CIRCLE or 0 for a draw
+};
+
+/***********************************************************************************************/
+
+class BookGen {
+	int games;
+	int workers;
+	int moveTime;                   // ms per move of the self-play, 0 for no limit
+	unsigned long long nodes;       // nodes per move of the self-play, 0 for no limit
+	int randomMoves;                // stones of a random opening
+	int plies;                      // moves of every game entered into the book
+	unsigned long long seed;
+	std::vector<OpeningBook::Entry> entries;
+	std::atomic<int> nextGame;
+	std::mutex lock;                // guards entries and the output
+	int played;                     // games of the self-play
+	int added;                      // games entered into the book
+	void playGame(Brain* brain, Field* field, int game, Game* record);
+	void worker();
+public:
+	BookGen();
+	bool parse(int argc, char** argv);
+	bool loadRecords(const char* fileName);
+	int loadGames(RecordReader* reader);
+	void addGame(const Game* game);
+	void selfPlay();
+	bool write(const char* fileName);
+};
+
+/***********************************************************************************************/
+
+BookGen::BookGen() {
+	games = 0;
+	workers = std::thread::hardware_concurrency();
+	if (workers < 1) workers = 1;
+	moveTime = 0;
+	nodes = 20000;
+	randomMoves = 2;
+	plies = BOOKPLIES;
+	seed = (unsigned long long) time(NULL);
+	played = 0;
+	added = 0;
+}
+
+bool BookGen::parse(int argc, char** argv) {
+	bool output = false;
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-games")) games = atoi(value);
+		else if (!strcmp(arg, "-workers")) workers = atoi(value) > 0 ? atoi(value) : 1;
+		else if (!strcmp(arg, "-time")) moveTime = atoi(value);
+		else if (!strcmp(arg, "-nodes")) nodes = strtoull(value, NULL, 10);
+		else if (!strcmp(arg, "-random")) randomMoves = atoi(value);
+		else if (!strcmp(arg, "-plies")) plies = atoi(value);
+		else if (!strcmp(arg, "-seed")) seed = strtoull(value, NULL, 10);
+		else if (!strcmp(arg, "-records")) {
+			if (!loadRecords(value)) {
+				printf("cannot read %s\n", value);
+				return false;
+			}
+		} else if (!strcmp(arg, "-out")) output = true;
+		else return false;
+	}
+	if (argc % 2 == 0) return false;   // every option has a value
+	if (plies < 1 || plies > BOOKPLIES) plies = BOOKPLIES;
+	if (randomMoves > plies) randomMoves = plies;
+	return output && (moveTime || nodes);
+}
+
+/* a game record file written by RecordWriter, or one game per line, "i,j" for every stone, a cross first;
+   a game of the text file is won by the stone making five */
+bool BookGen::loadRecords(const char* fileName) {
+	RecordReader reader;
+	if (reader.open(fileName)) {
+		int loaded = loadGames(&reader);
+		printf("%d of %d games read from %s\n", loaded, reader.size(), fileName);
+		return true;
+	}
+	FILE* f = fopen(fileName, "r");
+	if (!f) return false;
+	Field* field = new Field();
+	Game* game = new Game();
+	char line[8192];
+	int loaded = 0;
+	while (fgets(line, sizeof(line), f)) {
+		for (int i = 0; i < NUMCOLS; i++)
+			for (int j = 0; j < NUMROWS; j++)
+				field->set(i, j, 0);
+		game->length = 0;
+		game->winner = 0;
+		int player = CROSS;
+		const char* s = line;
+		int i, j, n;
+		while (!game->winner && game->length < MAXGAMELENGTH && sscanf(s, "%d,%d%n", &i, &j, &n) == 2) {
+			if (i < 0 || i >= NUMCOLS || j < 0 || j >= NUMROWS || field->at(i, j)) break;
+			field->set(i, j, player);
+			game->moves[game->length].i = i;
+			game->moves[game->length].j = j;
+			game->length++;
+			if (field->isFive(player, i, j, NULL, NULL, NULL)) game->winner = player;
+			player = (player == CIRCLE) ? CROSS : CIRCLE;
+			s += n;
+		}
+		if (game->length) {
+			addGame(game);
+			loaded++;
+		}
+	}
+	fclose(f);
+	delete game;
+	delete field;
+	printf("%d games read from %s\n", loaded, fileName);
+	return true;
+}
+
+/* the finished games of the record file played on this board and begun by a cross */
+int BookGen::loadGames(RecordReader* reader) {
+	Field* field = new Field();
+	Game* game = new Game();
+	RecordedGame recorded;
+	int loaded = 0;
+	while (reader->next(&recorded)) {
+		const RecordHeader* header = recorded.header;
+		if (header->cols != NUMCOLS || header->rows != NUMROWS || !header->result || (header->flags & RECORDCIRCLEFIRST))
+			continue;
+		for (int i = 0; i < NUMCOLS; i++)
+			for (int j = 0; j < NUMROWS; j++)
+				field->set(i, j, 0);
+		MoveCursor cursor(&recorded);
+		game->length = 0;
+		while (game->length < MAXGAMELENGTH && cursor.next(field)) {
+			game->moves[game->length].i = cursor.i;
+			game->moves[game->length].j = cursor.j;
+			game->length++;
+		}
+		game->winner = (header->result == RECORDDRAW) ? 0 : header->result;
+		if (game->length) {
+			addGame(game);
+			loaded++;
+		}
+	}
+	delete game;
+	delete field;
+	return loaded;
+}
+
+/* enter the first plies moves of game into the book, seen by the player making them */
+void BookGen::addGame(const Game* game) {
+	Field* field = new Field();
+	OpeningBook::Entry entry[BOOKPLIES];
+	int n = 0;
+	int player = CROSS;
+	for (int m = 0; m < game->length && m < plies; m++) {
+		OpeningBook::Symmetry symmetry;
+		int ci, cj;
+		entry[n].key = OpeningBook::canonicalKey(field, player, &symmetry);
+		OpeningBook::toCanonical(&symmetry, game->moves[m].i, game->moves[m].j, &ci, &cj);
+		entry[n].i = (short) ci;
+		entry[n].j = (short) cj;
+		entry[n].games = 1;
+		entry[n].wins = game->winner == player;
+		entry[n].draws = game->winner == 0;
+		n++;
+		field->set(game->moves[m].i, game->moves[m].j, player);
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+	delete field;
+	lock.lock();
+	entries.insert(entries.end(), entry, entry + n);
+	added++;
+	lock.unlock();
+}
+
+void BookGen::playGame(Brain* brain, Field* field, int game, Game* record) {
+	for (int i = 0; i < NUMCOLS; i++)
+		for (int j = 0; j < NUMROWS; j++)
+			field->set(i, j, 0);
+	brain->setSeed(seed ^ (0xbf58476d1ce4e5b9ULL * (game + 1)));  // the game decides the choices of the engine
+	record->length = 0;
+	record->winner = 0;
+	// random stones in the middle of the field spread the games over many openings,
+	// there is at least one as the engine does not search the empty field
+	unsigned long long state = seed ^ (0x9e3779b97f4a7c15ULL * (game + 1));
+	int player = CROSS;
+	while (record->length < (randomMoves > 1 ? randomMoves : 1)) {
+		int i = NUMCOLS/2 - 3 + (int) (splitMix64(&state) % 7);
+		int j = NUMROWS/2 - 3 + (int) (splitMix64(&state) % 7);
+		if (field->at(i, j)) continue;
+		field->set(i, j, player);
+		record->moves[record->length].i = i;
+		record->moves[record->length].j = j;
+		record->length++;
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+	while (!brain->isDraw()) {
+		int i, j;
+		brain->startSearch(player, moveTime);
+		brain->waitSearch(&i, &j);
+		field->set(i, j, player);
+		record->moves[record->length].i = i;
+		record->moves[record->length].j = j;
+		record->length++;
+		if (field->isFive(player, i, j, NULL, NULL, NULL)) {
+			record->winner = player;
+			return;
+		}
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+}
+
+void BookGen::worker() {
+	Field* field = new Field();
+	Brain* brain = new Brain(field, BOOKTRANSSIZE);
+	brain->setThreads(1);
+	brain->setNodeLimit(nodes);
+	Game* record = new Game();
+	for (int game = nextGame++; game < games; game = nextGame++) {
+		playGame(brain, field, game, record);
+		addGame(record);
+		lock.lock();
+		played++;
+		if (played % 10 == 0 || played == games) {
+			printf("%d games played\n", played);
+			fflush(stdout);
+		}
+		lock.unlock();
+	}
+	delete record;
+	delete brain;
+	delete field;
+}
+
+void BookGen::selfPlay() {
+	if (!games) return;
+	nextGame = 0;
+	std::thread* threads = new std::thread[workers];
+	for (int w = 0; w < workers; w++)
+		threads[w] = std::thread(&BookGen::worker, this);
+	for (int w = 0; w < workers; w++)
+		threads[w].join();
+	delete[] threads;
+}
+
+bool BookGen::write(const char* fileName) {
+	if (entries.empty()) return false;
+	if (!OpeningBook::write(fileName, &entries[0], (int) entries.size())) return false;
+	OpeningBook book;
+	if (!book.open(fileName)) return false;
+	printf("%d moves of %d games written to %s\n", book.size(), added, fileName);
+	return true;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	BookGen* bookGen = new BookGen();
+	if (!bookGen->parse(argc, argv)) {
+		printf("usage: bookgen -out file [-records file] [-games n] [-workers n] [-time ms] [-nodes n]\n"
+			"               [-random stones] [-plies n] [-seed n]\n");
+		delete bookGen;
+		return 1;
+	}
+	bookGen->selfPlay();
+	const char* fileName = NULL;
+	for (int k = 1; k + 1 < argc; k++)
+		if (!strcmp(argv[k], "-out")) fileName = argv[k + 1];
+	int status = 0;
+	if (!bookGen->write(fileName)) {
+		printf("no book written to %s\n", fileName);
+		status = 1;
+	}
+	delete bookGen;
+	return status;
+}
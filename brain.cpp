@@ -0,0 +1,2346 @@
+#include <string.h>
+#include <assert.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "brain.h"
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows>
+BasicField<numCols, numRows>::BasicField() {
+	static_assert(maxLine <= 32, "a line is kept in the bits of one word");
+	memset(bits, 0, sizeof(bits));
+	memset(pernament, 0, sizeof(pernament));
+	memset(neighbours, 0, sizeof(neighbours));
+	stones = 0;
+	frontierSize = 0;
+}
+
+template<int numCols, int numRows>
+int BasicField<numCols, numRows>::at(int i, int j) const {
+	if (i < 0 || i >= numCols || j < 0 || j >= numRows) return 0;
+	// rows are the first numRows lines, so row j is line j and column i is position i
+	return ((bits[CIRCLE][j] >> i) & 1) * CIRCLE + ((bits[CROSS][j] >> i) & 1) * CROSS;
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::set(int i, int j, int item) {
+	int old = at(i, j);
+	for (int d = 0; d < 4; d++) {
+		int line = lineOf[i][j][d];
+		unsigned mask = 1u << linePos[i][j][d];
+		bits[CIRCLE][line] &= ~mask;
+		bits[CROSS][line] &= ~mask;
+		if (item) {
+			bits[item][line] |= mask;
+			bits[0][line] |= mask;
+		} else
+			bits[0][line] &= ~mask;
+	}
+	if ((old == 0) == (item == 0)) return;
+	int change = item ? 1 : -1;
+	stones += change;
+	if (neighbours[i][j]) {
+		if (item) removeFrontier(i, j);
+		else addFrontier(i, j);
+	}
+	for (int ii = i - 1; ii <= i + 1; ii++) {
+		if (ii < 0 || ii >= numCols) continue;
+		for (int jj = j - 1; jj <= j + 1; jj++) {
+			if (jj < 0 || jj >= numRows || (ii == i && jj == j)) continue;
+			neighbours[ii][jj] += change;
+			// an empty cell enters the frontier with its first neighbour and leaves it with the last one
+			if (neighbours[ii][jj] == (item ? 1 : 0) && !at(ii, jj)) {
+				if (item) addFrontier(ii, jj);
+				else removeFrontier(ii, jj);
+			}
+		}
+	}
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::addFrontier(int i, int j) {
+	frontierIndex[i][j] = frontierSize;
+	frontier[frontierSize].i = i;
+	frontier[frontierSize++].j = j;
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::removeFrontier(int i, int j) {
+	Cell last = frontier[--frontierSize];
+	frontier[frontierIndex[i][j]] = last;
+	frontierIndex[last.i][last.j] = frontierIndex[i][j];
+}
+
+template<int numCols, int numRows>
+bool BasicField<numCols, numRows>::isPernament(int i, int j) {
+	return (pernament[j] >> i) & 1;
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::setPernament(int i, int j, bool pernament) {
+	if (pernament)
+		this->pernament[j] |= 1u << i;
+	else
+		this->pernament[j] &= ~(1u << i);
+}
+
+template<int numCols, int numRows>
+int BasicField<numCols, numRows>::lineItem(int line, int pos) {
+	return ((bits[CIRCLE][line] >> pos) & 1) * CIRCLE + ((bits[CROSS][line] >> pos) & 1) * CROSS;
+}
+
+template<int numCols, int numRows>
+unsigned BasicField<numCols, numRows>::lineBits(int line, int item) {
+	return bits[item][line];
+}
+
+template<int numCols, int numRows>
+bool BasicField<numCols, numRows>::isFrontier(int i, int j) {
+	if (i < 0 || i >= numCols || j < 0 || j >= numRows) return false;
+	return neighbours[i][j] && !at(i, j);
+}
+
+template<int numCols, int numRows>
+unsigned BasicField<numCols, numRows>::fiveMask(int line, int player) {
+	unsigned w = bits[player][line];
+	unsigned m = w & (w >> 1);
+	m &= m >> 2;
+	return m & (w >> 4);
+}
+
+template<int numCols, int numRows>
+int BasicField<numCols, numRows>::findFive(int player) {
+#if defined(__AVX2__)
+	for (int l = 0; l < lineWords; l += 8) {
+		__m256i w = _mm256_loadu_si256((const __m256i*) &bits[player][l]);
+		__m256i m = _mm256_and_si256(w, _mm256_srli_epi32(w, 1));
+		m = _mm256_and_si256(m, _mm256_srli_epi32(m, 2));
+		m = _mm256_and_si256(m, _mm256_srli_epi32(w, 4));
+		if (_mm256_testz_si256(m, m)) continue;
+		for (int line = l; line < l + 8; line++)
+			if (fiveMask(line, player)) return line;
+	}
+#elif defined(USE_SSE2)
+	for (int l = 0; l < lineWords; l += 4) {
+		__m128i w = _mm_loadu_si128((const __m128i*) &bits[player][l]);
+		__m128i m = _mm_and_si128(w, _mm_srli_epi32(w, 1));
+		m = _mm_and_si128(m, _mm_srli_epi32(m, 2));
+		m = _mm_and_si128(m, _mm_srli_epi32(w, 4));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(m, _mm_setzero_si128())) == 0xffff) continue;
+		for (int line = l; line < l + 4; line++)
+			if (fiveMask(line, player)) return line;
+	}
+#else
+	for (int line = 0; line < numLines; line++)
+		if (fiveMask(line, player)) return line;
+#endif
+	return -1;
+}
+
+template<int numCols, int numRows>
+bool BasicField<numCols, numRows>::isFive(int player, int i, int j, int* vi, int* vj, int* direction) {
+	for (int d = 0; d < 4; d++) {
+		int line = lineOf[i][j][d];
+		int pos = linePos[i][j][d];
+		// only fives starting on positions pos-4..pos pass through [i,j]
+		unsigned mask = fiveMask(line, player) & (pos >= 4 ? 0x1fu << (pos - 4) : 0x1fu >> (4 - pos));
+		if (!mask) continue;
+		int k;
+		for (k = 0; !((mask >> k) & 1); k++);
+		if (vi) *vi = lineCells[line][k].i;
+		if (vj) *vj = lineCells[line][k].j;
+		if (direction) *direction = d + 1;
+		return true;
+	}
+	return false;
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::pack(unsigned char* packed) const {
+	memset(packed, 0, packedSize);
+	for (int j = 0; j < numRows; j++)
+		for (int i = 0; i < numCols; i++) {
+			int c = j*numCols + i;
+			packed[c >> 2] |= at(i, j) << (2*(c & 3));
+		}
+}
+
+template<int numCols, int numRows>
+void BasicField<numCols, numRows>::unpack(const unsigned char* packed) {
+	for (int j = 0; j < numRows; j++)
+		for (int i = 0; i < numCols; i++) {
+			int c = j*numCols + i;
+			set(i, j, (packed[c >> 2] >> (2*(c & 3))) & 3);
+		}
+}
+
+/***********************************************************************************************/
+
+/* a 64-bit pseudo-random generator, good enough for zobrist codes */
+unsigned long long splitMix64(unsigned long long* state) {
+	unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* hashed, so every thread sees the same bonus and a search can be repeated. There is none once a bound of the
+   window is a win or a loss, the shifted window would make the replies look for other distances */
+int noiseBonus(unsigned long long key, int noise, int alpha, int beta) {
+	if (!noise || (alpha > -INFSCORE && alpha < -WINSCORE + 1000) || (beta < INFSCORE && beta > WINSCORE - 1000)
+		|| alpha > WINSCORE - 1000 || beta < -WINSCORE + 1000)
+		return 0;
+	return (int) (splitMix64(&key) % noise);
+}
+
+int runScore(int own, int other) {
+	static const int attack[5] = {0, 2, 20, 300, 100000};
+	static const int defence[5] = {0, 1, 15, 200, 50000};
+	return attack[own] + defence[other];
+}
+
+TransTable::TransTable(int size) {
+	this->size = size;
+	slots = new Slot[size];
+	clear();
+}
+
+TransTable::~TransTable() {
+	delete[] slots;
+}
+
+int TransTable::sizeFor(long long bytes) {
+	long long size = bytes / (long long) sizeof(Slot);
+	return size > INT_MAX ? INT_MAX : (int) (size > 1 ? size : 1);
+}
+
+void TransTable::clear() {
+	for (int i = 0; i < size; i++) {
+		slots[i].check.store(0, std::memory_order_relaxed);
+		slots[i].data.store(0, std::memory_order_relaxed);
+	}
+	age = 1;                        // entries with age 0 are empty
+}
+
+void TransTable::newSearch() {
+	// searches starting together may both see the old age, one of them then shares the new age of the other
+	unsigned char next = age.load(std::memory_order_relaxed) + 1;
+	age.store(next >= 64 ? 1 : next, std::memory_order_relaxed);  // the age has 6 bits
+}
+
+bool TransTable::probe(unsigned long long key, Entry* entry) {
+	Slot* slot = &slots[key % size];
+	unsigned long long data = slot->data.load(std::memory_order_relaxed);
+	if ((slot->check.load(std::memory_order_relaxed) ^ data) != key || (data >> 58) == 0) return false;
+	entry->key = key;
+	entry->value = (int) (unsigned) data;
+	entry->move = (short) (data >> 32);
+	entry->depth = (unsigned char) (data >> 48);
+	entry->flags = (unsigned char) (data >> 56);
+	return true;
+}
+
+void TransTable::store(unsigned long long key, int depth, int bound, int value, int move) {
+	Slot* slot = &slots[key % size];
+	unsigned long long old = slot->data.load(std::memory_order_relaxed);
+	unsigned long long age = this->age.load(std::memory_order_relaxed);
+	// keep deeper results of the current search, replace anything left over from the previous ones
+	if ((old >> 58) == age && (int) ((old >> 48) & 0xff) > depth) return;
+	if (move < 0 && (slot->check.load(std::memory_order_relaxed) ^ old) == key)
+		move = (short) (old >> 32);
+	unsigned long long data = (unsigned) value
+		| ((unsigned long long) (unsigned short) move << 32)
+		| ((unsigned long long) depth << 48)
+		| ((unsigned long long) (bound | (age << 2)) << 56);
+	slot->check.store(key ^ data, std::memory_order_relaxed);
+	slot->data.store(data, std::memory_order_relaxed);
+}
+
+/***********************************************************************************************/
+
+Evaluation::Evaluation() {
+	strcpy(blocks[0].string, " pp $"); blocks[0].value = 200;
+	strcpy(blocks[1].string, " ppp $"); blocks[1].value = 5000;
+	strcpy(blocks[2].string, "pppp $"); blocks[2].value = 8000;
+	strcpy(blocks[3].string, "oppp $"); blocks[3].value = 100;
+	strcpy(blocks[4].string, " pppo$"); blocks[4].value = 100;
+	strcpy(blocks[5].string, " pp p $"); blocks[5].value = 5000;
+	strcpy(blocks[6].string, " p pp $"); blocks[6].value = 5000;
+	strcpy(blocks[7].string, "ppppp$"); blocks[7].value = 1000000;
+	strcpy(blocks[8].string, " pppp$"); blocks[8].value = 8000;
+	strcpy(blocks[9].string, "p ppp$"); blocks[9].value = 8000;
+	strcpy(blocks[10].string, "pp pp$"); blocks[10].value = 8000;
+	strcpy(blocks[11].string, "ppp p$"); blocks[11].value = 8000;
+	strcpy(blocks[12].string, " p p $"); blocks[12].value = 200;
+	strcpy(blocks[13].string, " oo $"); blocks[13].value = -300;
+	strcpy(blocks[14].string, " ooo $"); blocks[14].value = -7000;
+	strcpy(blocks[15].string, "oooo $"); blocks[15].value = -13000;
+	strcpy(blocks[16].string, "pooo $"); blocks[16].value = -200;
+	strcpy(blocks[17].string, " ooop$"); blocks[17].value = -200;
+	strcpy(blocks[18].string, " oo o $"); blocks[18].value = -7000;
+	strcpy(blocks[19].string, " o oo $"); blocks[19].value = -7000;
+	strcpy(blocks[20].string, "ooooo$"); blocks[20].value = -1200000;
+	strcpy(blocks[21].string, " oooo$"); blocks[21].value = -13000;
+	strcpy(blocks[22].string, "o ooo$"); blocks[22].value = -13000;
+	strcpy(blocks[23].string, "oo oo$"); blocks[23].value = -13000;
+	strcpy(blocks[24].string, "ooo o$"); blocks[24].value = -13000;
+	strcpy(blocks[25].string, " o o $"); blocks[25].value = -300;
+	maxBlockLength = 0;
+	for (int k = 0; k < NUMBLOCKS; k++)
+		if ((int) strlen(blocks[k].string) - 1 > maxBlockLength)
+			maxBlockLength = strlen(blocks[k].string) - 1;
+	assert(maxBlockLength < BLOCKWINDOW);
+	compile();
+}
+
+void Evaluation::compile() {
+	bool openThree[NUMBLOCKS];
+	for (int k = 0; k < NUMBLOCKS; k++) {
+		int len = strlen(blocks[k].string) - 1;
+		int stones = 0;
+		openThree[k] = blocks[k].string[0] == ' ' && blocks[k].string[len - 1] == ' ';
+		for (int l = 0; l < len; l++) {
+			if (blocks[k].string[l] == 'p') stones++;
+			if (blocks[k].string[l] == 'o') openThree[k] = false;
+		}
+		if (stones != 3) openThree[k] = false;
+	}
+	for (int code = 0; code < (1 << (2*BLOCKWINDOW)); code++) {
+		for (int player = CIRCLE; player <= CROSS; player++) {
+			blockTable[code][player] = 0;
+			threeTable[code][player] = 0;
+			for (int k = 0; k < NUMBLOCKS; k++) {
+				if (!matches(k, code, player)) continue;
+				blockTable[code][player] += blocks[k].value;
+				if (openThree[k]) threeTable[code][player]++;
+			}
+		}
+	}
+}
+
+bool Evaluation::matches(int k, int code, int player) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	for (int l = 0; l < BLOCKWINDOW; l++) {
+		int item = (code >> (2*l)) & 3;
+		if (item == 3) return false;  // the block (including its '$') must fit on the line
+		char c = blocks[k].string[l];
+		if (c == '$') return true;
+		if (!((c == ' ' && item == 0) || (c == 'p' && item == player) || (c == 'o' && item == opponent)))
+			return false;
+	}
+	return false;
+}
+
+bool Evaluation::load(const char* fileName) {
+	FILE* f = fopen(fileName, "r");
+	if (!f) return false;
+	int values[NUMBLOCKS];
+	for (int k = 0; k < NUMBLOCKS; k++)
+		values[k] = blocks[k].value;
+	char line[256];
+	bool valid = true;
+	while (valid && fgets(line, sizeof(line), f)) {
+		char string[16];
+		int value;
+		if (line[0] == '#' || line[strspn(line, " \t\r\n")] == 0) continue;
+		valid = sscanf(line, "%d \"%15[^\"]\"", &value, string) == 2;
+		int k = 0;
+		while (valid && k < NUMBLOCKS && strcmp(blocks[k].string, string)) k++;
+		if (k == NUMBLOCKS) valid = false;  // not a block of this engine
+		if (valid) values[k] = value;
+	}
+	fclose(f);
+	if (!valid) return false;
+	for (int k = 0; k < NUMBLOCKS; k++)
+		blocks[k].value = values[k];
+	compile();
+	return true;
+}
+
+bool Evaluation::save(const char* fileName) {
+	FILE* f = fopen(fileName, "w");
+	if (!f) return false;
+	fprintf(f, "# value \"block\": p a stone of the player, o one of the opponent, ' ' an empty cell, $ any cell past the block\n");
+	for (int k = 0; k < NUMBLOCKS; k++)
+		fprintf(f, "%d \"%s\"\n", blocks[k].value, blocks[k].string);
+	return fclose(f) == 0;
+}
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows>
+BasicBrain<numCols, numRows>::BasicBrain(Field* field, int transSize) {
+	init(field, new TransTable(transSize));
+	ownTable = true;
+}
+
+template<int numCols, int numRows>
+BasicBrain<numCols, numRows>::BasicBrain(Field* field, TransTable* table) {
+	init(field, table);
+	ownTable = false;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::init(Field* field, TransTable* table) {
+	this->field = field;
+	transTable = table;
+	setSeed((unsigned long long) time(NULL));
+	numThreads = 0;
+	setThreads(std::thread::hardware_concurrency());
+	threatSearch = new ThreatSearch(this);
+	proofSearch = NULL;
+	proofNodes = 0;
+	proofSize = PROOFSIZE;
+	book = new OpeningBook();
+	searching = false;
+	stop = false;
+	deadline = 0;
+	nodeLimit = 0;
+	depthLimit = MAXDEPTH;
+	noise = ROOTNOISE;
+	progress = 0;
+	winLength = 0;
+	memset(&lastIteration, 0, sizeof(lastIteration));
+	lastIteration.i = lastIteration.j = -1;
+	lastNodes[0] = lastNodes[1] = 0;
+	iterationCallback = NULL;
+	iterationData = NULL;
+	statsLog = NULL;
+	resultI = -1;
+	resultJ = -1;
+	expectI = -1;
+	expectJ = -1;
+	pondering = false;
+}
+
+template<int numCols, int numRows>
+BasicBrain<numCols, numRows>::~BasicBrain() {
+	stopWorker();
+	for (int t = 0; t < numThreads; t++)
+		delete searchers[t];
+	delete threatSearch;
+	delete proofSearch;
+	delete book;
+	if (ownTable) delete transTable;
+	if (statsLog) fclose(statsLog);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setThreads(int n) {
+	if (n < 1) n = 1;               // hardware_concurrency may not know
+	if (n > MAXTHREADS) n = MAXTHREADS;
+	for (; numThreads > n; numThreads--)
+		delete searchers[numThreads - 1];
+	for (; numThreads < n; numThreads++)
+		searchers[numThreads] = new Searcher(this, numThreads);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setSeed(unsigned long long seed) {
+	for (int i = 0; i < numCols; i++)
+		for (int j = 0; j < numRows; j++) 
+			for (int k = 0; k < 3; k++)
+				zobristCodes[i][j][k] = splitMix64(&seed);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			zobristTurn[i][j] = splitMix64(&seed);
+	transTable->clear();
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setNoise(int amount) {
+	noise = amount > 0 ? amount : 0;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::initTransTable() {
+	if (pondering) {                // the game pondered on is over
+		pondering = false;
+		stopWorker();
+	}
+	transTable->clear();
+	for (int t = 0; t < numThreads; t++)
+		searchers[t]->clearHistory();
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::isVictory(int player, int* vi, int* vj, int* direction) {
+	int line = field->findFive(player);
+	if (line < 0) return false;
+	unsigned mask = field->fiveMask(line, player);
+	int k;
+	for (k = 0; !((mask >> k) & 1); k++);
+	if (vi) *vi = Field::lineCells[line][k].i;
+	if (vj) *vj = Field::lineCells[line][k].j;
+	if (direction) *direction = Field::lineDirection[line] + 1;
+	return true;
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::isVictory(int player, int i, int j, int* vi, int* vj, int* direction) {
+	return field->isFive(player, i, j, vi, vj, direction);
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::isDraw() {
+	return field->frontierSize == 0;
+}
+
+/* add one to a counter which only its own thread writes, the others may read it meanwhile */
+inline void count(std::atomic<unsigned long long>* counter) {
+	counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+#ifdef SEARCHPROFILE
+inline long long profileClock() {   // ns of the steady clock
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+template<int numCols, int numRows>
+BasicSearcher<numCols, numRows>::BasicSearcher(Brain* brain, int index) {
+	this->brain = brain;
+	this->index = index;
+	clearCounters();
+	pvLength[0] = 0;
+	clearHistory();
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::clearCounters() {
+	nodes = 0;
+	tableProbes = 0;
+	tableHits = 0;
+	tableStores = 0;
+	cutoffs = 0;
+	firstCutoffs = 0;
+	evalTime = 0;
+	genTime = 0;
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::clearHistory() {
+	memset(killers, 0xff, sizeof(killers));
+	memset(history, 0, sizeof(history));
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::initZobristKey() {
+	zobristKey = brain->positionKey(&field);
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::scoreLine(int line, int from, int to, int* score) {
+	int len = Field::lineLength[line];
+	int code = 0;
+	for (int l = BLOCKWINDOW - 1; l >= 0; l--) {
+		int item = (to + l < len) ? field.lineItem(line, to + l) : 3;
+		code = (code << 2) | item;
+	}
+	for (int s = to; ; s--) {
+		score[CIRCLE] += brain->evaluation.blockTable[code][CIRCLE];
+		score[CROSS] += brain->evaluation.blockTable[code][CROSS];
+		if (s == from) break;
+		code = ((code << 2) | field.lineItem(line, s - 1)) & ((1 << (2*BLOCKWINDOW)) - 1);
+	}
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::updateLines(int i, int j, int item) {
+	int delta[4][3];
+	for (int d = 0; d < 4; d++) {
+		int pos = Field::linePos[i][j][d];
+		int from = pos - brain->evaluation.maxBlockLength + 1 > 0 ? pos - brain->evaluation.maxBlockLength + 1 : 0;
+		delta[d][CIRCLE] = delta[d][CROSS] = 0;
+		scoreLine(Field::lineOf[i][j][d], from, pos, delta[d]);
+		delta[d][CIRCLE] = -delta[d][CIRCLE];
+		delta[d][CROSS] = -delta[d][CROSS];
+	}
+	field.set(i, j, item);
+	for (int d = 0; d < 4; d++) {
+		int line = Field::lineOf[i][j][d];
+		int pos = Field::linePos[i][j][d];
+		int from = pos - brain->evaluation.maxBlockLength + 1 > 0 ? pos - brain->evaluation.maxBlockLength + 1 : 0;
+		scoreLine(line, from, pos, delta[d]);
+		for (int player = CIRCLE; player <= CROSS; player++) {
+			lineScore[line][player] += delta[d][player];
+			totalScore[player] += delta[d][player];
+		}
+	}
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::initLineScores() {
+	totalScore[CIRCLE] = 0;
+	totalScore[CROSS] = 0;
+	for (int line = 0; line < Field::numLines; line++) {
+		lineScore[line][CIRCLE] = lineScore[line][CROSS] = 0;
+		scoreLine(line, 0, Field::lineLength[line] - 1, lineScore[line]);
+		totalScore[CIRCLE] += lineScore[line][CIRCLE];
+		totalScore[CROSS] += lineScore[line][CROSS];
+	}
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::makeMove(int i, int j, int player) {
+	updateLines(i, j, player);
+	field.setPernament(i, j, false);
+	zobristKey ^= brain->zobristCodes[i][j][0];
+	zobristKey ^= brain->zobristCodes[i][j][player];
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::unmakeMove(int i, int j, int player) {
+	updateLines(i, j, 0);
+	zobristKey ^= brain->zobristCodes[i][j][player];
+	zobristKey ^= brain->zobristCodes[i][j][0];
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::payOff(int player) {
+	return totalScore[player];
+}
+
+/* hashed from the key of the root and the move; the leaves stay free of noise, their values agree with the
+   transposition table */
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::rootNoise(int i, int j, int alpha, int beta) {
+	return noiseBonus(zobristKey ^ brain->zobristCodes[i][j][rootPlayer], brain->noise, alpha, beta);
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::threatScore(int player, int i, int j) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int result = 0;
+	for (int d = 0; d < 4; d++) {
+		int line = Field::lineOf[i][j][d];
+		int pos = Field::linePos[i][j][d];
+		int len = Field::lineLength[line];
+		// length of the runs of stones of the same colour touching [i,j] from both sides
+		int runs[3] = {0, 0, 0};
+		int item = (pos > 0) ? field.lineItem(line, pos - 1) : 0;
+		for (int k = pos - 1; item && k >= 0 && field.lineItem(line, k) == item && runs[item] < 4; k--)
+			runs[item]++;
+		int item2 = (pos < len - 1) ? field.lineItem(line, pos + 1) : 0;
+		int run = 0;
+		for (int k = pos + 1; item2 && k < len && field.lineItem(line, k) == item2 && run < 4; k++)
+			run++;
+		runs[item2] = (item2 == item) ? (runs[item2] + run > 4 ? 4 : runs[item2] + run) : run;
+		result += runScore(runs[player], runs[opponent]);
+	}
+	return result;
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::generateMoves(int player, int depth, Move* moves) {
+	int n = field.frontierSize;
+	for (int k = 0; k < n; k++) {
+		int i = field.frontier[k].i;
+		int j = field.frontier[k].j;
+		int tie = history[player][i][j] < ORDERSCALE - 3 ? history[player][i][j] : ORDERSCALE - 3;
+		if (killers[depth][0].i == i && killers[depth][0].j == j)
+			tie = ORDERSCALE - 1;
+		else if (killers[depth][1].i == i && killers[depth][1].j == j)
+			tie = ORDERSCALE - 2;
+		moves[k].i = i;
+		moves[k].j = j;
+		// the threats decide; ranking killers or history above them costs several times the nodes
+		moves[k].score = threatScore(player, i, j) * ORDERSCALE + tie;
+	}
+	// insertion sort, ties in raster order so that the order does not depend on the frontier history
+	for (int k = 1; k < n; k++) {
+		Move m = moves[k];
+		int l;
+		for (l = k - 1; l >= 0 && (moves[l].score < m.score
+			|| (moves[l].score == m.score && (moves[l].i > m.i || (moves[l].i == m.i && moves[l].j > m.j)))); l--)
+			moves[l + 1] = moves[l];
+		moves[l + 1] = m;
+	}
+	return n;
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::addCutoff(int player, int depth, int maxDepth, int i, int j) {
+	if (killers[depth][0].i != i || killers[depth][0].j != j) {
+		killers[depth][1] = killers[depth][0];
+		killers[depth][0].i = i;
+		killers[depth][0].j = j;
+	}
+	history[player][i][j] += (maxDepth - depth) * (maxDepth - depth);
+	if (history[player][i][j] > (1 << 24)) {  // keep the counts from overflowing
+		for (int p = CIRCLE; p <= CROSS; p++)
+			for (int ii = 0; ii < numCols; ii++)
+				for (int jj = 0; jj < numRows; jj++)
+					history[p][ii][jj] >>= 1;
+	}
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::promoteMove(Move* moves, int numMoves, int i, int j) {
+	for (int m = 0; m < numMoves; m++) {
+		if (moves[m].i != i || moves[m].j != j) continue;
+		Move move = moves[m];
+		memmove(&moves[1], &moves[0], m * sizeof(Move));
+		moves[0] = move;
+		return;
+	}
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::valueToTable(int value, int depth) {
+	if (value > WINSCORE - 1000) return value + depth;
+	if (value < -WINSCORE + 1000) return value - depth;
+	return value;
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::tableToValue(int value, int depth) {
+	if (value > WINSCORE - 1000) return value - depth;
+	if (value < -WINSCORE + 1000) return value + depth;
+	return value;
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::pvs(int player, int depth, int maxDepth, int alpha, int beta) {
+	count(&nodes);
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	bool pvNode = beta - alpha > 1;
+	pvLength[depth] = depth;
+	unsigned long long key = zobristKey ^ brain->zobristTurn[rootPlayer][player];
+	TransTable::Entry entry;
+	bool found = brain->transTable->probe(key, &entry);
+	count(&tableProbes);
+	if (found) count(&tableHits);
+	// principal variation nodes search on, so that their line stays complete
+	if (found && depth > 0 && !pvNode && entry.depth >= maxDepth - depth) {
+		int value = tableToValue(entry.value, depth);
+		int bound = entry.flags & 3;
+		if (bound == EXACT) return value;
+		if (bound == LOWERBOUND && value >= beta) return value;
+		if (bound == UPPERBOUND && value <= alpha) return value;
+	}
+	if (depth == maxDepth) {
+#ifdef SEARCHPROFILE
+		long long t0 = profileClock();
+#endif
+		int result = payOff(rootPlayer);  // the blocks are valued by the root player
+#ifdef SEARCHPROFILE
+		evalTime.store(evalTime.load(std::memory_order_relaxed) + profileClock() - t0, std::memory_order_relaxed);
+#endif
+		if (player != rootPlayer) result = -result;
+		brain->transTable->store(key, 0, EXACT, valueToTable(result, depth), -1);
+		count(&tableStores);
+		return result;
+	}
+	if (maxDepth > 1 && (brain->timeUp() || (brain->nodeLimit && nodes >= brain->nodeLimit))) {
+		timeout = true;
+		return 0;
+	}
+	int origAlpha = alpha;
+	Move moves[numCols*numRows];
+#ifdef SEARCHPROFILE
+	long long t0 = profileClock();
+#endif
+	int numMoves = generateMoves(player, depth, moves);
+#ifdef SEARCHPROFILE
+	genTime.store(genTime.load(std::memory_order_relaxed) + profileClock() - t0, std::memory_order_relaxed);
+#endif
+	// try the move of the previous principal variation first, then the hash move
+	if (found && entry.move >= 0)
+		promoteMove(moves, numMoves, entry.move / numRows, entry.move % numRows);
+	if (followPV && depth < lastPVLength)
+		promoteMove(moves, numMoves, lastPV[depth].i, lastPV[depth].j);
+	bool onPV = followPV && depth < lastPVLength && moves[0].i == lastPV[depth].i && moves[0].j == lastPV[depth].j;
+	int optI = -1;
+	int optJ = -1;
+	int best = numMoves ? -INFSCORE : 0;
+	for (int m = 0; m < numMoves && alpha < beta; m++) {
+		int ii = moves[m].i;
+		int jj = moves[m].j;
+		int price;
+		int bonus = depth ? 0 : rootNoise(ii, jj, alpha, beta);  // the window of the reply is shifted by it
+		followPV = onPV && m == 0;
+		makeMove(ii, jj, player);
+		if (field.isFive(player, ii, jj, NULL, NULL, NULL))  // decided, no need to search any further
+			price = WINSCORE - depth;
+		else {
+			if (m == 0)
+				price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - beta, bonus - alpha);
+			else {
+				// the first move is expected to be the best, the others only have to be proven worse
+				price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - alpha - 1, bonus - alpha);
+				if (!timeout && price > alpha && price < beta)
+					price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - beta, bonus - alpha);
+			}
+			if (price > WINSCORE - 1000 || price < -WINSCORE + 1000) price -= bonus;  // the shorter win still counts
+		}
+		unmakeMove(ii, jj, player);
+		if (timeout) return 0;
+		if (price > best) best = price;
+		if (price >= beta) {
+			count(&cutoffs);
+			if (m == 0) count(&firstCutoffs);
+			if (price < WINSCORE - depth)  // a five is found without any ordering
+				addCutoff(player, depth, maxDepth, ii, jj);
+		}
+		if (price > alpha) {
+			alpha = price;
+			optI = ii;
+			optJ = jj;
+			pv[depth][depth].i = ii;
+			pv[depth][depth].j = jj;
+			for (int k = depth + 1; k < pvLength[depth + 1]; k++)
+				pv[depth][k] = pv[depth + 1][k];
+			pvLength[depth] = pvLength[depth + 1] > depth + 1 ? pvLength[depth + 1] : depth + 1;
+			if (depth == 0) {
+				bestPrice = price;
+				bestI = ii;
+				bestJ = jj;
+			}
+		}
+	}
+	followPV = false;
+	int result = best;
+	int bound = EXACT;
+	if (result <= origAlpha)
+		bound = UPPERBOUND;
+	else if (result >= beta)
+		bound = LOWERBOUND;
+	brain->transTable->store(key, maxDepth - depth, bound, valueToTable(result, depth), optI >= 0 ? optI*numRows + optJ : -1);
+	count(&tableStores);
+	return result;
+}
+
+template<int numCols, int numRows>
+int BasicSearcher<numCols, numRows>::iterate(int player, int maxDepth, int value) {
+	int alpha = -INFSCORE;
+	int beta = INFSCORE;
+	int delta = ASPIRATION;
+	if (value > -WINSCORE + 1000 && value < WINSCORE - 1000) {
+		alpha = value - delta;
+		beta = value + delta;
+	}
+	lastPVLength = pvLength[0];
+	for (int k = 0; k < lastPVLength; k++)
+		lastPV[k] = pv[0][k];
+	for (;;) {
+		followPV = true;
+		int result = pvs(player, 0, maxDepth, alpha, beta);
+		if (timeout) return result;
+		// outside of the window the value is only a bound, search again in a wider one
+		if (result <= alpha && alpha > -INFSCORE) {
+			delta *= 4;
+			alpha = (result - delta > -INFSCORE) ? result - delta : -INFSCORE;
+		} else if (result >= beta && beta < INFSCORE) {
+			delta *= 4;
+			beta = (result + delta < INFSCORE) ? result + delta : INFSCORE;
+		} else
+			return result;
+	}
+}
+
+template<int numCols, int numRows>
+void BasicSearcher<numCols, numRows>::search(const Field* position, int player) {
+	field = *position;
+	timeout = false;
+	rootPlayer = player;
+	initZobristKey();
+	initLineScores();
+	bestPrice = -INFSCORE;
+	completedDepth = 0;
+	pvLength[0] = 0;
+	// the killers belong to the previous position, the history is worth keeping at half weight
+	memset(killers, 0xff, sizeof(killers));
+	for (int p = CIRCLE; p <= CROSS; p++)
+		for (int i = 0; i < numCols; i++)
+			for (int j = 0; j < numRows; j++)
+				history[p][i][j] >>= 1;
+	// the value swings between odd and even depths, the window is set by the last iteration of the same parity
+	int value[2] = {INFSCORE, INFSCORE};
+	// helpers with an odd index start one iteration deeper so that the threads spread over more of the tree,
+	// the first iteration of the main thread is always finished so that there is a move to play
+	for (int d = 1 + (index & 1); d == 1 || (!brain->timeUp() && d <= brain->depthLimit); d++) {
+		value[d & 1] = iterate(player, d, value[d & 1]);
+		if (timeout) break;
+		completedDepth = d;
+		brain->publish(d, bestI, bestJ, bestPrice);
+	}
+}
+
+template<int numCols, int numRows>
+BasicBatchEvaluator<numCols, numRows>::BasicBatchEvaluator() {
+	for (int line = 0; line < Field::numLines; line++)
+		for (int pos = 0; pos < Field::lineLength[line]; pos++)
+			lineIndex[line][pos] = (short) (Field::lineCells[line][pos].j * numCols + Field::lineCells[line][pos].i);
+	numThreads = 1;
+}
+
+template<int numCols, int numRows>
+void BasicBatchEvaluator<numCols, numRows>::setThreads(int n) {
+	numThreads = n < 1 ? 1 : (n > MAXTHREADS ? MAXTHREADS : n);
+}
+
+/* the windows of every line are scored from its end to its start as in BasicSearcher::scoreLine, with the
+   code of the window of every lane in one vector and its values gathered from the block table */
+template<int numCols, int numRows>
+void BasicBatchEvaluator<numCols, numRows>::evaluateGroup(const unsigned char* positions, int count,
+	const unsigned char* players, int* values) {
+	unsigned char cells[numCols*numRows][BATCHLANES];  // the positions transposed, a cell of all lanes together
+	int stones[BATCHLANES];
+	for (int lane = 0; lane < BATCHLANES; lane++) {
+		const unsigned char* packed = positions + lane * Field::packedSize;
+		stones[lane] = 0;
+		for (int c = 0; c < numCols*numRows; c++) {
+			int item = lane < count ? (packed[c >> 2] >> (2*(c & 3))) & 3 : 0;
+			cells[c][lane] = (unsigned char) item;
+			if (item) stones[lane]++;
+		}
+	}
+	const int mask = (1 << (2*BLOCKWINDOW)) - 1;
+	int score[3][BATCHLANES];
+#if defined(__AVX2__)
+	// the values of CIRCLE and CROSS are next to each other in the table, one 64-bit gather fetches both
+	__m256i low = _mm256_setzero_si256();   // CIRCLE and CROSS of lanes 0..3
+	__m256i high = _mm256_setzero_si256();  // of lanes 4..7
+	for (int line = 0; line < Field::numLines; line++) {
+		__m256i code = _mm256_set1_epi32(mask);  // the cells past the end are off the field
+		for (int pos = Field::lineLength[line] - 1; pos >= 0; pos--) {
+			__m256i item = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) cells[lineIndex[line][pos]]));
+			code = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi32(code, 2), item), _mm256_set1_epi32(mask));
+			__m256i index = _mm256_add_epi32(code, _mm256_slli_epi32(code, 1));  // 3 ints per entry
+			const long long* base = (const long long*) &evaluation.blockTable[0][CIRCLE];
+			low = _mm256_add_epi32(low, _mm256_i32gather_epi64(base, _mm256_castsi256_si128(index), 4));
+			high = _mm256_add_epi32(high, _mm256_i32gather_epi64(base, _mm256_extracti128_si256(index, 1), 4));
+		}
+	}
+	int pairs[2*BATCHLANES];
+	_mm256_storeu_si256((__m256i*) pairs, low);
+	_mm256_storeu_si256((__m256i*) (pairs + BATCHLANES), high);
+	for (int lane = 0; lane < BATCHLANES; lane++) {
+		score[CIRCLE][lane] = pairs[2*lane];
+		score[CROSS][lane] = pairs[2*lane + 1];
+	}
+#else
+	int code[BATCHLANES];
+	for (int lane = 0; lane < BATCHLANES; lane++)
+		score[CIRCLE][lane] = score[CROSS][lane] = 0;
+	for (int line = 0; line < Field::numLines; line++) {
+		for (int lane = 0; lane < BATCHLANES; lane++)
+			code[lane] = mask;
+		for (int pos = Field::lineLength[line] - 1; pos >= 0; pos--) {
+			const unsigned char* item = cells[lineIndex[line][pos]];
+			for (int lane = 0; lane < BATCHLANES; lane++) {
+				code[lane] = ((code[lane] << 2) | item[lane]) & mask;
+				score[CIRCLE][lane] += evaluation.blockTable[code[lane]][CIRCLE];
+				score[CROSS][lane] += evaluation.blockTable[code[lane]][CROSS];
+			}
+		}
+	}
+#endif
+	for (int lane = 0; lane < count; lane++) {
+		int player = players ? players[lane] : ((stones[lane] & 1) ? CIRCLE : CROSS);
+		values[lane] = score[player][lane];
+	}
+}
+
+template<int numCols, int numRows>
+void BasicBatchEvaluator<numCols, numRows>::evaluateRange(const unsigned char* positions, const unsigned char* players,
+	int* values, int from, int to) {
+	for (int k = from; k < to; k += BATCHLANES)
+		evaluateGroup(positions + (long long) k * Field::packedSize, to - k < BATCHLANES ? to - k : BATCHLANES,
+			players ? players + k : NULL, values + k);
+}
+
+template<int numCols, int numRows>
+void BasicBatchEvaluator<numCols, numRows>::evaluate(const unsigned char* positions, int n, const unsigned char* players,
+	int* values) {
+	int groups = (n + BATCHLANES - 1) / BATCHLANES;
+	int threads = numThreads < groups ? numThreads : groups;
+	if (threads <= 1) {
+		evaluateRange(positions, players, values, 0, n);
+		return;
+	}
+	// every thread takes whole groups, the last one what is left
+	std::thread workers[MAXTHREADS];
+	for (int t = 0; t < threads; t++) {
+		int from = (int) ((long long) groups * t / threads) * BATCHLANES;
+		int to = (int) ((long long) groups * (t + 1) / threads) * BATCHLANES;
+		workers[t] = std::thread(&BasicBatchEvaluator::evaluateRange, this, positions, players, values, from, to < n ? to : n);
+	}
+	for (int t = 0; t < threads; t++)
+		workers[t].join();
+}
+
+/***********************************************************************************************/
+
+/* number of set bits */
+int bitCount(unsigned x) {
+	int n = 0;
+	for (; x; x &= x - 1) n++;
+	return n;
+}
+
+template<int numCols, int numRows>
+BasicThreatSearch<numCols, numRows>::BasicThreatSearch(Brain* brain) {
+	this->brain = brain;
+	memset(mark, 0, sizeof(mark));
+	markStamp = 0;
+	length = 0;
+}
+
+template<int numCols, int numRows>
+void BasicThreatSearch<numCols, numRows>::startMark() {
+	if (++markStamp == 0) {
+		memset(mark, 0, sizeof(mark));
+		markStamp = 1;
+	}
+}
+
+template<int numCols, int numRows>
+int BasicThreatSearch<numCols, numRows>::threeCount(int i, int j) {
+	int result = 0;
+	for (int d = 0; d < 4; d++) {
+		int line = Field::lineOf[i][j][d];
+		int pos = Field::linePos[i][j][d];
+		int len = Field::lineLength[line];
+		int from = pos - brain->evaluation.maxBlockLength + 1 > 0 ? pos - brain->evaluation.maxBlockLength + 1 : 0;
+		for (int s = from; s <= pos; s++) {
+			int code = 0;
+			for (int l = BLOCKWINDOW - 1; l >= 0; l--)
+				code = (code << 2) | ((s + l < len) ? field.lineItem(line, s + l) : 3);
+			result += brain->evaluation.threeTable[code][attacker];
+		}
+	}
+	return result;
+}
+
+template<int numCols, int numRows>
+int BasicThreatSearch<numCols, numRows>::completions(int player, int i, int j, Cell* cells, int max) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int n = 0;
+	for (int d = 0; d < 4 && n < max; d++) {
+		int line = Field::lineOf[i][j][d];
+		int pos = Field::linePos[i][j][d];
+		unsigned own = field.lineBits(line, player);
+		unsigned other = field.lineBits(line, opponent);
+		for (int k = (pos >= 4 ? pos - 4 : 0); k <= pos && k + 5 <= Field::lineLength[line] && n < max; k++) {
+			unsigned window = 0x1fu << k;
+			if (bitCount(own & window) != 4 || (other & window)) continue;
+			int e;
+			for (e = k; (own >> e) & 1; e++);
+			Cell c = Field::lineCells[line][e];
+			bool known = false;
+			for (int m = 0; m < n; m++)
+				if (cells[m].i == c.i && cells[m].j == c.j) known = true;
+			if (!known) cells[n++] = c;
+		}
+	}
+	return n;
+}
+
+template<int numCols, int numRows>
+bool BasicThreatSearch<numCols, numRows>::hasCompletion(int player) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	for (int line = 0; line < Field::numLines; line++) {
+		unsigned own = field.lineBits(line, player);
+		if (bitCount(own) < 4) continue;
+		unsigned other = field.lineBits(line, opponent);
+		for (int k = 0; k + 5 <= Field::lineLength[line]; k++)
+			if (bitCount(own & (0x1fu << k)) == 4 && !(other & (0x1fu << k))) return true;
+	}
+	return false;
+}
+
+template<int numCols, int numRows>
+int BasicThreatSearch<numCols, numRows>::collectMoves(int player, int need, Cell* cells) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int n = 0;
+	startMark();
+	for (int line = 0; line < Field::numLines; line++) {
+		unsigned own = field.lineBits(line, player);
+		if (bitCount(own) < need) continue;
+		unsigned other = field.lineBits(line, opponent);
+		for (int k = 0; k + 5 <= Field::lineLength[line]; k++) {
+			unsigned window = 0x1fu << k;
+			if (bitCount(own & window) != need || (other & window)) continue;
+			for (int e = k; e < k + 5; e++) {
+				if ((own >> e) & 1) continue;
+				Cell c = Field::lineCells[line][e];
+				if (mark[c.i][c.j] == markStamp) continue;
+				mark[c.i][c.j] = markStamp;
+				cells[n++] = c;
+			}
+		}
+	}
+	return n;
+}
+
+template<int numCols, int numRows>
+bool BasicThreatSearch<numCols, numRows>::attack(int depth, int threes) {
+	Cell moves[numCols*numRows];
+	Cell replies[4*BLOCKWINDOW*4];
+	if (++nodes > maxNodes) return false;
+	// a four of the attacker wins at once, a four of the defender has to be blocked instead of threatening
+	int numMoves = collectMoves(attacker, 4, moves);
+	if (numMoves) {
+		line[2*depth] = moves[0];
+		length = 2*depth + 1;
+		return true;
+	}
+	if (hasCompletion(defender) || depth >= MAXTHREATDEPTH) return false;
+	numMoves = collectMoves(attacker, 3, moves);
+	for (int m = 0; m < numMoves; m++) {
+		int i = moves[m].i;
+		int j = moves[m].j;
+		field.set(i, j, attacker);
+		Cell defence[2];
+		int n = completions(attacker, i, j, defence, 2);
+		bool win = false;
+		if (n >= 2) {               // an open or a double four, the defender cannot block both
+			line[2*depth + 1] = defence[0];
+			line[2*depth + 2] = defence[1];
+			length = 2*depth + 3;
+			win = true;
+		} else if (n == 1) {
+			field.set(defence[0].i, defence[0].j, defender);
+			win = attack(depth + 1, threes);
+			field.set(defence[0].i, defence[0].j, 0);
+			line[2*depth + 1] = defence[0];
+		}
+		field.set(i, j, 0);
+		if (win) {
+			line[2*depth] = moves[m];
+			return true;
+		}
+		if (nodes > maxNodes) return false;
+	}
+	// open threes give the defender several answers, and he could answer with a four of his own
+	if (threes == 0 || collectMoves(defender, 3, moves)) return false;
+	numMoves = collectMoves(attacker, 2, moves);
+	for (int m = 0; m < numMoves; m++) {
+		int i = moves[m].i;
+		int j = moves[m].j;
+		int before = threeCount(i, j);
+		field.set(i, j, attacker);
+		if (threeCount(i, j) <= before) {
+			field.set(i, j, 0);
+			continue;
+		}
+		// the defender has to take a cell where the attacker would make an open four, or one of its ends
+		int numReplies = 0;
+		startMark();
+		for (int d = 0; d < 4; d++) {
+			int l = Field::lineOf[i][j][d];
+			int pos = Field::linePos[i][j][d];
+			for (int k = (pos >= 4 ? pos - 4 : 0); k <= pos + 4 && k < Field::lineLength[l]; k++) {
+				Cell c = Field::lineCells[l][k];
+				if (field.at(c.i, c.j)) continue;
+				field.set(c.i, c.j, attacker);
+				Cell ends[2];
+				if (completions(attacker, c.i, c.j, ends, 2) >= 2) {
+					Cell cells[3] = {c, ends[0], ends[1]};
+					for (int e = 0; e < 3; e++) {
+						if (mark[cells[e].i][cells[e].j] == markStamp) continue;
+						mark[cells[e].i][cells[e].j] = markStamp;
+						replies[numReplies++] = cells[e];
+					}
+				}
+				field.set(c.i, c.j, 0);
+			}
+		}
+		// searched backwards, so that a won line continues with the answer to the first reply
+		bool win = numReplies > 0;
+		for (int r = numReplies - 1; r >= 0 && win; r--) {
+			field.set(replies[r].i, replies[r].j, defender);
+			win = attack(depth + 1, threes - 1);
+			field.set(replies[r].i, replies[r].j, 0);
+		}
+		field.set(i, j, 0);
+		if (win) {
+			line[2*depth] = moves[m];
+			line[2*depth + 1] = replies[0];
+			return true;
+		}
+		if (nodes > maxNodes) return false;
+	}
+	return false;
+}
+
+template<int numCols, int numRows>
+bool BasicThreatSearch<numCols, numRows>::findWin(const Field* position, int player, bool threes, int maxNodes) {
+	field = *position;
+	attacker = player;
+	defender = (player == CIRCLE) ? CROSS : CIRCLE;
+	nodes = 0;
+	this->maxNodes = maxNodes;
+	// the open threes are deepened one at a time, short wins are found before the budget runs out
+	for (int n = 0; n <= (threes ? MAXTHREES : 0) && nodes <= maxNodes; n++)
+		if (attack(0, n)) return true;
+	length = 0;
+	return false;
+}
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows>
+BasicProofSearch<numCols, numRows>::BasicProofSearch(Brain* brain, int size) {
+	this->brain = brain;
+	this->size = size < 2 ? 2 : size & ~1;
+	table = new Entry[this->size];
+	memset(table, 0, this->size * sizeof(Entry));
+	age = 0;
+	threatSearch = new ThreatSearch(brain);
+	children = new Cell[(MAXPROOFDEPTH + 1) * numCols * numRows];
+	childPhi = new unsigned[(MAXPROOFDEPTH + 1) * numCols * numRows];
+	childDelta = new unsigned[(MAXPROOFDEPTH + 1) * numCols * numRows];
+	nodes = 0;
+	length = 0;
+}
+
+template<int numCols, int numRows>
+BasicProofSearch<numCols, numRows>::~BasicProofSearch() {
+	delete[] table;
+	delete threatSearch;
+	delete[] children;
+	delete[] childPhi;
+	delete[] childDelta;
+}
+
+template<int numCols, int numRows>
+int BasicProofSearch<numCols, numRows>::sizeFor(long long bytes) {
+	long long n = bytes / (long long) sizeof(Entry);
+	return n > INT_MAX ? INT_MAX : (int) n;
+}
+
+template<int numCols, int numRows>
+typename BasicProofSearch<numCols, numRows>::Entry* BasicProofSearch<numCols, numRows>::probe(unsigned long long key) {
+	Entry* bucket = &table[(key % (size / 2)) * 2];
+	if (bucket[0].key == key && bucket[0].age == age) return &bucket[0];
+	if (bucket[1].key == key && bucket[1].age == age) return &bucket[1];
+	return NULL;
+}
+
+template<int numCols, int numRows>
+void BasicProofSearch<numCols, numRows>::store(unsigned long long key, unsigned phi, unsigned delta, unsigned long long work, int move) {
+	Entry* bucket = &table[(key % (size / 2)) * 2];
+	Entry* entry;
+	if (bucket[0].key == key && bucket[0].age == age) entry = &bucket[0];
+	else if (bucket[1].key == key && bucket[1].age == age) entry = &bucket[1];
+	else if (bucket[0].age != age) entry = &bucket[0];
+	else if (bucket[1].age != age) entry = &bucket[1];
+	else entry = bucket[0].work <= bucket[1].work ? &bucket[0] : &bucket[1];
+	entry->key = key;
+	entry->age = age;
+	entry->phi = phi;
+	entry->delta = delta;
+	entry->work = work < UINT_MAX ? (unsigned) work : UINT_MAX;
+	entry->move = (short) move;
+}
+
+template<int numCols, int numRows>
+int BasicProofSearch<numCols, numRows>::completions(int player, Cell* cells, int max) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int n = 0;
+	for (int line = 0; line < Field::numLines; line++) {
+		unsigned own = field.lineBits(line, player);
+		if (bitCount(own) < 4) continue;
+		unsigned other = field.lineBits(line, opponent);
+		for (int k = 0; k + 5 <= Field::lineLength[line]; k++) {
+			unsigned window = 0x1fu << k;
+			if (bitCount(own & window) != 4 || (other & window)) continue;
+			int e;
+			for (e = k; (own >> e) & 1; e++);
+			Cell c = Field::lineCells[line][e];
+			bool known = false;
+			for (int m = 0; m < n; m++)
+				if (cells[m].i == c.i && cells[m].j == c.j) known = true;
+			if (known) continue;
+			cells[n++] = c;
+			if (n == max) return n;
+		}
+	}
+	return n;
+}
+
+template<int numCols, int numRows>
+void BasicProofSearch<numCols, numRows>::nearCells(unsigned* near) {
+	// row j is line j with column i on position i, a step along a row or a diagonal is a shift
+	unsigned rows[numRows + 4];
+	rows[0] = rows[1] = rows[numRows + 2] = rows[numRows + 3] = 0;
+	for (int j = 0; j < numRows; j++)
+		rows[j + 2] = field.lineBits(j, 0);
+	unsigned all = numCols < 32 ? (1u << numCols) - 1 : ~0u;
+	for (int j = 0; j < numRows; j++) {
+		unsigned m = rows[j + 2] << 1 | rows[j + 2] >> 1 | rows[j + 2] << 2 | rows[j + 2] >> 2;
+		for (int s = 1; s <= 2; s++) {
+			unsigned other = rows[j + 2 - s] | rows[j + 2 + s];
+			m |= other | other << s | other >> s;
+		}
+		near[j] = m & ~rows[j + 2] & all;
+	}
+}
+
+template<int numCols, int numRows>
+int BasicProofSearch<numCols, numRows>::moveScore(int player, int i, int j, int* threat) {
+	static const int weight[5] = {0, 1, 8, 64, 512};
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int result = 0;
+	*threat = 0;
+	for (int d = 0; d < 4; d++) {
+		int line = Field::lineOf[i][j][d];
+		int pos = Field::linePos[i][j][d];
+		unsigned own = field.lineBits(line, player);
+		unsigned other = field.lineBits(line, opponent);
+		for (int k = (pos >= 4 ? pos - 4 : 0); k <= pos && k + 5 <= Field::lineLength[line]; k++) {
+			unsigned window = 0x1fu << k;
+			if (!(other & window)) {
+				int count = bitCount(own & window);
+				result += 2 * weight[count];
+				if (count > *threat) *threat = count;
+			}
+			if (!(own & window)) result += weight[bitCount(other & window)];  // blocking counts half
+		}
+	}
+	return result;
+}
+
+template<int numCols, int numRows>
+int BasicProofSearch<numCols, numRows>::generateMoves(int player, int depth, Cell* moves, unsigned* phi, unsigned* delta, int* move) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	Cell cells[2];
+	*move = -1;
+	// five at once reaches the goal of either side, two fours of the opponent cannot both be blocked
+	if (completions(player, cells, 1)) {
+		*phi = 0;
+		*delta = PROOFINF;
+		*move = cells[0].i * numRows + cells[0].j;
+		return -1;
+	}
+	int n = completions(opponent, cells, 2);
+	if (n == 2) {
+		*phi = PROOFINF;
+		*delta = 0;
+		*move = cells[0].i * numRows + cells[0].j;
+		return -1;
+	}
+	if (depth >= MAXPROOFDEPTH) limited = true;
+	if (depth >= MAXPROOFDEPTH || field.stones == numCols * numRows) {  // the attacker has not won
+		*phi = player == attacker ? PROOFINF : 0;
+		*delta = player == attacker ? 0 : PROOFINF;
+		return -1;
+	}
+	unsigned* initial = &childDelta[depth * numCols * numRows];
+	if (n == 1) {
+		moves[0] = cells[0];
+		initial[0] = 1;
+		return 1;
+	}
+	// a win by continuous fours leaves the opponent only forced answers and is exact, a win of the defender
+	// decides the node as well
+	if (threatSearch->findWin(&field, player, false, PROOFTHREATNODES)) {
+		*phi = 0;
+		*delta = PROOFINF;
+		*move = threatSearch->line[0].i * numRows + threatSearch->line[0].j;
+		return -1;
+	}
+	if (!field.stones && player == attacker) {
+		moves[0].i = numCols / 2;
+		moves[0].j = numRows / 2;
+		initial[0] = 1;
+		if (numCols * numRows > 1) restricted = true;
+		return 1;
+	}
+	// the cells near the stones ordered by their windows; a move of the attacker which makes no four is
+	// expected to take longer to prove, so the fours are tried first
+	int scores[numCols*numRows];
+	unsigned near[numRows];
+	nearCells(near);
+	n = 0;
+	for (int j = 0; j < numRows; j++)
+		for (unsigned m = near[j]; m; m &= m - 1) {
+			int i = 0;
+			while (!((m >> i) & 1)) i++;
+			int threat;
+			int score = moveScore(player, i, j, &threat);
+			int l;
+			for (l = n - 1; l >= 0 && scores[l] < score; l--) {
+				moves[l + 1] = moves[l];
+				scores[l + 1] = scores[l];
+				initial[l + 1] = initial[l];
+			}
+			moves[l + 1].i = i;
+			moves[l + 1].j = j;
+			scores[l + 1] = score;
+			initial[l + 1] = player == attacker && threat < 3 ? PROOFQUIET : 1;
+			n++;
+		}
+	// the defender may answer anywhere, so that a proof holds against every defence; the cells far from the
+	// stones follow the near ones, they seldom stop a win and are refuted by the same attack
+	if (player != attacker) {
+		for (int j = 0; j < numRows; j++)
+			for (int i = 0; i < numCols; i++)
+				if (!field.at(i, j) && !((near[j] >> i) & 1)) {
+					moves[n].i = i;
+					moves[n].j = j;
+					initial[n++] = 1;
+				}
+	} else if (n < numCols * numRows - field.stones)
+		restricted = true;
+	return n;
+}
+
+template<int numCols, int numRows>
+unsigned long long BasicProofSearch<numCols, numRows>::childKey(unsigned long long key, int player, Cell move) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	return key ^ brain->zobristCodes[move.i][move.j][0] ^ brain->zobristCodes[move.i][move.j][player]
+		^ brain->zobristTurn[attacker][player] ^ brain->zobristTurn[attacker][opponent];
+}
+
+template<int numCols, int numRows>
+void BasicProofSearch<numCols, numRows>::mid(unsigned long long key, int player, int depth, unsigned thPhi, unsigned thDelta) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	if ((maxNodes && nodes >= maxNodes) || ((nodes & 1023) == 0 && (brain->stop || (deadline && Brain::now() >= deadline)))) {
+		aborted = true;
+		return;
+	}
+	unsigned long long before = nodes++;
+	Cell* moves = &children[depth * numCols * numRows];
+	unsigned phi, delta;
+	int move;
+	int numMoves = generateMoves(player, depth, moves, &phi, &delta, &move);
+	if (numMoves < 0) {
+		store(key, phi, delta, 1, move);
+		return;
+	}
+	// the numbers of the children are looked up once, then only those of the child searched change;
+	// a child not searched yet has phi 1 and the delta given by generateMoves
+	unsigned* phis = &childPhi[depth * numCols * numRows];
+	unsigned* deltas = &childDelta[depth * numCols * numRows];
+	for (int m = 0; m < numMoves; m++) {
+		Entry* entry = probe(childKey(key, player, moves[m]));
+		phis[m] = entry ? entry->phi : 1;
+		if (entry) deltas[m] = entry->delta;
+	}
+	while (true) {
+		// phi is the least delta of the children, delta the sum of their phi
+		unsigned second = PROOFINF;
+		int best = 0;
+		phi = PROOFINF;
+		delta = 0;
+		for (int m = 0; m < numMoves; m++) {
+			if (deltas[m] < phi) {
+				second = phi;
+				phi = deltas[m];
+				best = m;
+			} else if (deltas[m] < second)
+				second = deltas[m];
+			delta = delta + phis[m] < PROOFINF ? delta + phis[m] : PROOFINF;
+		}
+		move = moves[best].i * numRows + moves[best].j;
+		if (phi >= thPhi || delta >= thDelta || aborted) break;
+		// the best child is searched until it is no longer the best, the second best gets a quarter more room
+		unsigned childThPhi = thDelta - delta + phis[best];
+		unsigned childThDelta = second + second / 4 + 1 < thPhi ? second + second / 4 + 1 : thPhi;
+		unsigned long long child = childKey(key, player, moves[best]);
+		field.set(moves[best].i, moves[best].j, player);
+		mid(child, opponent, depth + 1, childThPhi, childThDelta);
+		field.set(moves[best].i, moves[best].j, 0);
+		Entry* entry = probe(child);
+		if (entry) {
+			phis[best] = entry->phi;
+			deltas[best] = entry->delta;
+		}
+	}
+	store(key, phi, delta, nodes - before, move);
+}
+
+template<int numCols, int numRows>
+void BasicProofSearch<numCols, numRows>::findLine(unsigned long long key, int player) {
+	length = 0;
+	for (int depth = 0; depth <= MAXPROOFDEPTH; depth++) {
+		Entry* entry = probe(key);
+		if (!entry || (entry->phi && entry->delta)) {  // replaced by another position, search it again
+			mid(key, player, depth, PROOFINF, PROOFINF);
+			entry = probe(key);
+			if (!entry || (entry->phi && entry->delta)) return;
+		}
+		int move = entry->move;
+		if (player != attacker && !entry->delta) {
+			// every defence loses, the line follows the one which took the most nodes to refute
+			Cell* moves = &children[depth * numCols * numRows];
+			unsigned phi, delta;
+			int numMoves = generateMoves(player, depth, moves, &phi, &delta, &move);
+			unsigned most = 0;
+			for (int m = 0; m < numMoves; m++) {
+				Entry* child = probe(childKey(key, player, moves[m]));
+				if (child && !child->phi && (child->work > most || move < 0)) {
+					most = child->work;
+					move = moves[m].i * numRows + moves[m].j;
+				}
+			}
+		}
+		if (move < 0) return;
+		Cell cell = {move / numRows, move % numRows};
+		line[length++] = cell;
+		field.set(cell.i, cell.j, player);
+		if (field.isFive(player, cell.i, cell.j, NULL, NULL, NULL)) return;
+		key = childKey(key, player, cell);
+		player = (player == CIRCLE) ? CROSS : CIRCLE;
+	}
+}
+
+template<int numCols, int numRows>
+int BasicProofSearch<numCols, numRows>::solve(const Field* position, int player, int attacker, unsigned long long maxNodes,
+	long long deadline) {
+	field = *position;
+	this->attacker = attacker;
+	this->maxNodes = maxNodes;
+	this->deadline = deadline;
+	nodes = 0;
+	length = 0;
+	aborted = false;
+	limited = false;
+	restricted = false;
+	// the entries of the earlier solves are left in the table and ignored, it is only cleared once in 255 calls
+	if (++age == 0) {
+		memset(table, 0, size * sizeof(Entry));
+		age = 1;
+	}
+	unsigned long long key = brain->positionKey(&field) ^ brain->zobristTurn[attacker][player];
+	mid(key, player, 0, PROOFINF, PROOFINF);
+	Entry* root = probe(key);
+	if (!root || (root->phi && root->delta)) return 0;
+	// the numbers of the root are those of the player to move, the attacker's goal is phi if he is to move
+	bool won = (player == attacker) == (root->phi == 0);
+	if (!won) return limited ? 0 : (restricted ? DISPROVEDNEAR : DISPROVED);
+	findLine(key, player);
+	return PROVED;
+}
+
+/***********************************************************************************************/
+
+MappedFile::MappedFile() {
+	data = NULL;
+	size = 0;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char* fileName) {
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	fileHandle = file;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		size = (size_t) fileSize.QuadPart;
+		mapHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapHandle) data = (const unsigned char*) MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int file = ::open(fileName, O_RDONLY);
+	if (file < 0) return false;
+	struct stat status;
+	if (fstat(file, &status) == 0 && status.st_size > 0) {
+		size = (size_t) status.st_size;
+		void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+		if (mapping != MAP_FAILED) data = (const unsigned char*) mapping;
+	}
+	::close(file);                  // the mapping stays valid
+#endif
+	if (!data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapHandle) CloseHandle((HANDLE) mapHandle);
+	if (fileHandle) CloseHandle((HANDLE) fileHandle);
+#else
+	if (data) munmap((void*) data, size);
+#endif
+	data = NULL;
+	size = 0;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+/***********************************************************************************************/
+
+#define BOOKMAGIC "GMKBOOK1"        // first 8 bytes of a book, the number of entries follows
+
+struct BookHeader {
+	char magic[8];
+	unsigned long long numEntries;
+};
+
+OpeningBook::OpeningBook() {
+	entries = NULL;
+	numEntries = 0;
+}
+
+OpeningBook::~OpeningBook() {
+	close();
+}
+
+bool OpeningBook::open(const char* fileName) {
+	close();
+	if (!file.open(fileName)) return false;
+	const BookHeader* header = (const BookHeader*) file.data;
+	if (file.size < sizeof(BookHeader) || memcmp(header->magic, BOOKMAGIC, 8) || header->numEntries > INT_MAX
+		|| sizeof(BookHeader) + header->numEntries * sizeof(Entry) != file.size) {
+		close();
+		return false;
+	}
+	entries = (const Entry*) (header + 1);
+	numEntries = (int) header->numEntries;
+	return true;
+}
+
+void OpeningBook::close() {
+	file.close();
+	entries = NULL;
+	numEntries = 0;
+}
+
+int OpeningBook::size() {
+	return numEntries;
+}
+
+void OpeningBook::transform(int t, int i, int j, int* u, int* v) {
+	*u = (t & 1) ? j : i;
+	*v = (t & 1) ? i : j;
+	if (t & 2) *u = -*u;
+	if (t & 4) *v = -*v;
+}
+
+template<int numCols, int numRows>
+unsigned long long OpeningBook::canonicalKey(const BasicField<numCols, numRows>* position, int player, Symmetry* symmetry) {
+	int stoneI[BOOKPLIES], stoneJ[BOOKPLIES], own[BOOKPLIES];
+	int n = 0;
+	for (int i = 0; i < numCols; i++)
+		for (int j = 0; j < numRows; j++)
+			if (position->at(i, j)) {
+				if (n == BOOKPLIES) return 0;
+				stoneI[n] = i;
+				stoneJ[n] = j;
+				own[n] = position->at(i, j) == player;
+				n++;
+			}
+	// the smallest key of the 8 symmetric positions, each shifted so that its stones start at 0,0
+	unsigned long long best = 0;
+	for (int t = 0; t < 8; t++) {
+		int u[BOOKPLIES], v[BOOKPLIES];
+		int minU = 0, minV = 0;
+		for (int k = 0; k < n; k++) {
+			transform(t, stoneI[k], stoneJ[k], &u[k], &v[k]);
+			if (!k || u[k] < minU) minU = u[k];
+			if (!k || v[k] < minV) minV = v[k];
+		}
+		unsigned long long key = 0;
+		for (int k = 0; k < n; k++) {
+			unsigned long long state = (unsigned long long) (u[k] - minU) << 32 | (unsigned long long) (v[k] - minV) << 8 | own[k];
+			key ^= splitMix64(&state);
+		}
+		if (!t || key < best) {
+			best = key;
+			symmetry->transform = t;
+			symmetry->offI = minU;
+			symmetry->offJ = minV;
+		}
+	}
+	return best ? best : 1;         // 0 is no key
+}
+
+void OpeningBook::toCanonical(const Symmetry* symmetry, int i, int j, int* ci, int* cj) {
+	transform(symmetry->transform, i, j, ci, cj);
+	*ci -= symmetry->offI;
+	*cj -= symmetry->offJ;
+}
+
+void OpeningBook::fromCanonical(const Symmetry* symmetry, int ci, int cj, int* i, int* j) {
+	int u = ci + symmetry->offI;
+	int v = cj + symmetry->offJ;
+	if (symmetry->transform & 2) u = -u;
+	if (symmetry->transform & 4) v = -v;
+	*i = (symmetry->transform & 1) ? v : u;
+	*j = (symmetry->transform & 1) ? u : v;
+}
+
+template<int numCols, int numRows>
+bool OpeningBook::probe(const BasicField<numCols, numRows>* position, int player, int* i, int* j) {
+	if (!numEntries) return false;
+	Symmetry symmetry;
+	unsigned long long key = canonicalKey(position, player, &symmetry);
+	if (!key) return false;
+	int low = 0, high = numEntries;  // the first entry of the key
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (entries[middle].key < key) low = middle + 1;
+		else high = middle;
+	}
+	double bestScore = -1;
+	for (int k = low; k < numEntries && entries[k].key == key; k++) {
+		const Entry* entry = &entries[k];
+		if (entry->games < BOOKMINGAMES) continue;
+		int mi, mj;
+		fromCanonical(&symmetry, entry->i, entry->j, &mi, &mj);
+		// the book does not know the edges, a move shifted off the field or onto a stone is skipped
+		if (mi < 0 || mi >= numCols || mj < 0 || mj >= numRows || position->at(mi, mj)) continue;
+		double score = (entry->wins + 0.5*entry->draws + 1) / (entry->games + 2);
+		if (score > bestScore) {
+			bestScore = score;
+			*i = mi;
+			*j = mj;
+		}
+	}
+	return bestScore >= 0;
+}
+
+int compareEntries(const void* a, const void* b) {
+	const OpeningBook::Entry* x = (const OpeningBook::Entry*) a;
+	const OpeningBook::Entry* y = (const OpeningBook::Entry*) b;
+	if (x->key != y->key) return x->key < y->key ? -1 : 1;
+	if (x->i != y->i) return x->i - y->i;
+	return x->j - y->j;
+}
+
+bool OpeningBook::write(const char* fileName, Entry* entries, int n) {
+	qsort(entries, n, sizeof(Entry), compareEntries);
+	int merged = 0;
+	for (int k = 0; k < n; k++) {
+		if (merged && !compareEntries(&entries[merged - 1], &entries[k])) {
+			entries[merged - 1].games += entries[k].games;
+			entries[merged - 1].wins += entries[k].wins;
+			entries[merged - 1].draws += entries[k].draws;
+		} else
+			entries[merged++] = entries[k];
+	}
+	FILE* f = fopen(fileName, "wb");
+	if (!f) return false;
+	BookHeader header;
+	memcpy(header.magic, BOOKMAGIC, 8);
+	header.numEntries = merged;
+	bool written = fwrite(&header, sizeof(header), 1, f) == 1
+		&& (int) fwrite(entries, sizeof(Entry), merged, f) == merged;
+	return fclose(f) == 0 && written;
+}
+
+/***********************************************************************************************/
+
+GameRecord::GameRecord() {
+	start(NUMCOLS, NUMROWS, CROSS, NULL, NULL, false);
+}
+
+void GameRecord::start(int cols, int rows, int first, const RecordEngine* crosses, const RecordEngine* circles, bool scores) {
+	memset(&header, 0, sizeof(header));
+	header.cols = (unsigned char) cols;
+	header.rows = (unsigned char) rows;
+	header.flags = (scores ? RECORDSCORES : 0) | (first == CIRCLE ? RECORDCIRCLEFIRST : 0);
+	if (crosses) header.engines[0] = *crosses;
+	if (circles) header.engines[1] = *circles;
+	lastI = cols / 2;
+	lastJ = rows / 2;
+}
+
+void GameRecord::add(int i, int j, int score, int depth) {
+	if (header.numMoves >= header.cols * header.rows) return;
+	unsigned char* p = moves + header.size;
+	int di = i - lastI, dj = j - lastJ;
+	if (di >= -7 && di <= 7 && dj >= -7 && dj <= 7)
+		*p++ = (unsigned char) (16*(di + 8) + dj + 8);
+	else {
+		int cell = j*header.cols + i;
+		*p++ = 0;
+		*p++ = (unsigned char) cell;
+		*p++ = (unsigned char) (cell >> 8);
+	}
+	if (header.flags & RECORDSCORES) {
+		for (int b = 0; b < 4; b++)
+			*p++ = (unsigned char) ((unsigned) score >> 8*b);
+		*p++ = (unsigned char) (depth < 255 ? depth : 255);
+	}
+	header.size = (unsigned short) (p - moves);
+	header.numMoves++;
+	lastI = i;
+	lastJ = j;
+}
+
+void GameRecord::finish(int result) {
+	header.result = (unsigned char) result;
+	while (header.size % 4)
+		moves[header.size++] = 0;
+}
+
+/***********************************************************************************************/
+
+RecordWriter::RecordWriter() {
+	file = NULL;
+}
+
+RecordWriter::~RecordWriter() {
+	close();
+}
+
+static bool truncateFile(const char* fileName, size_t size) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER position;
+	position.QuadPart = (LONGLONG) size;
+	bool truncated = SetFilePointerEx(file, position, NULL, FILE_BEGIN) && SetEndOfFile(file);
+	CloseHandle(file);
+	return truncated;
+#else
+	return truncate(fileName, (off_t) size) == 0;
+#endif
+}
+
+bool RecordWriter::open(const char* fileName) {
+	close();
+	RecordReader reader;
+	bool exists = reader.open(fileName);
+	size_t end = reader.validSize();
+	bool incomplete = exists && !reader.complete();
+	reader.close();                 // Windows cannot cut a mapped file
+	if (incomplete && !truncateFile(fileName, end)) return false;
+	if (!exists) {
+		// only a missing or empty file may be started anew
+		FILE* old = fopen(fileName, "rb");
+		if (old) {
+			bool empty = fgetc(old) == EOF;
+			fclose(old);
+			if (!empty) return false;
+		}
+	}
+	file = fopen(fileName, "ab");
+	if (!file) return false;
+	setvbuf(file, NULL, _IOFBF, RECORDBUFFER);
+	if (!exists && fwrite(RECORDMAGIC, 8, 1, file) != 1) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool RecordWriter::write(const GameRecord* game) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!file) return false;
+	// a game still being played is padded like finish would do it
+	static const unsigned char zeros[4] = {0, 0, 0, 0};
+	RecordHeader header = game->header;
+	int padding = (4 - header.size % 4) % 4;
+	header.size += padding;
+	return fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(game->moves, 1, game->header.size, file) == game->header.size
+		&& fwrite(zeros, 1, padding, file) == (size_t) padding;
+}
+
+bool RecordWriter::flush() {
+	std::lock_guard<std::mutex> guard(lock);
+	return file && fflush(file) == 0;
+}
+
+bool RecordWriter::close() {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!file) return true;
+	bool closed = fclose(file) == 0;
+	file = NULL;
+	return closed;
+}
+
+/***********************************************************************************************/
+
+RecordReader::RecordReader() {
+	close();
+}
+
+bool RecordReader::valid(size_t offset) {
+	if (file.size - offset < sizeof(RecordHeader)) return false;
+	const RecordHeader* header = (const RecordHeader*) (file.data + offset);
+	return header->cols >= 1 && header->cols <= 32 && header->rows >= 1 && header->rows <= 32
+		&& header->numMoves <= header->cols * header->rows && header->size % 4 == 0 && header->size <= RECORDSIZE
+		&& file.size - offset - sizeof(RecordHeader) >= header->size;
+}
+
+bool RecordReader::open(const char* fileName) {
+	close();
+	if (!file.open(fileName)) return false;
+	if (file.size < 8 || memcmp(file.data, RECORDMAGIC, 8)) {
+		close();
+		return false;
+	}
+	// count the games once, a game cut off by a crash of the writer ends the file
+	end = 8;
+	while (valid(end)) {
+		end += sizeof(RecordHeader) + ((const RecordHeader*) (file.data + end))->size;
+		numGames++;
+	}
+	position = 8;
+	return true;
+}
+
+void RecordReader::close() {
+	file.close();
+	position = 0;
+	end = 0;
+	numGames = 0;
+}
+
+int RecordReader::size() {
+	return numGames;
+}
+
+bool RecordReader::complete() {
+	return end == file.size;
+}
+
+size_t RecordReader::validSize() {
+	return end;
+}
+
+void RecordReader::rewind() {
+	position = 8;
+}
+
+bool RecordReader::next(RecordedGame* game) {
+	if (position >= end) return false;
+	game->header = (const RecordHeader*) (file.data + position);
+	game->moves = (const unsigned char*) (game->header + 1);
+	position += sizeof(RecordHeader) + game->header->size;
+	return true;
+}
+
+/***********************************************************************************************/
+
+MoveCursor::MoveCursor(const RecordedGame* game) {
+	data = game->moves;
+	end = game->moves + game->header->size;
+	cols = game->header->cols;
+	rows = game->header->rows;
+	scores = (game->header->flags & RECORDSCORES) != 0;
+	number = 0;
+	i = cols / 2;
+	j = rows / 2;
+	player = (game->header->flags & RECORDCIRCLEFIRST) ? CROSS : CIRCLE;  // the one before the first move
+	score = 0;
+	depth = 0;
+	numMoves = game->header->numMoves;
+}
+
+bool MoveCursor::next() {
+	if (number >= numMoves || data >= end) return false;
+	if (*data) {
+		i += (*data >> 4) - 8;
+		j += (*data & 15) - 8;
+		data++;
+	} else {
+		if (end - data < 3) return false;
+		int cell = data[1] | data[2] << 8;
+		i = cell % cols;
+		j = cell / cols;
+		data += 3;
+	}
+	if (scores) {
+		if (end - data < 5) return false;
+		score = (int) ((unsigned) data[0] | (unsigned) data[1] << 8 | (unsigned) data[2] << 16 | (unsigned) data[3] << 24);
+		depth = data[4];
+		data += 5;
+	}
+	player = (player == CIRCLE) ? CROSS : CIRCLE;
+	number++;
+	return i >= 0 && i < cols && j >= 0 && j < rows;
+}
+
+template<int numCols, int numRows>
+bool MoveCursor::next(BasicField<numCols, numRows>* field) {
+	if (!next() || i >= numCols || j >= numRows || field->at(i, j)) return false;
+	field->set(i, j, player);
+	return true;
+}
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows>
+long long BasicBrain<numCols, numRows>::now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::timeUp() {
+	long long d = deadline;
+	return stop || (d && now() >= d);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::publish(int depth, int i, int j, int price) {
+	unsigned long long value = (unsigned long long) depth << 56 | (unsigned long long) (i*numRows + j) << 32 | (unsigned) price;
+	unsigned long long old = progress;
+	while ((int) (old >> 56) < depth && !progress.compare_exchange_weak(old, value));
+	int unset = -1;
+	// the first thread to finish the depth records it
+	if (depth <= MAXDEPTH && depthTime[depth].compare_exchange_strong(unset, (int) (now() - start)))
+		recordIteration(depth, i, j, price);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::recordIteration(int depth, int i, int j, int price) {
+	IterationStats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.depth = depth;
+	stats.i = i;
+	stats.j = j;
+	stats.price = price;
+	stats.time = (int) (now() - start);
+	long long evalTime = 0, genTime = 0;
+	for (int t = 0; t < numThreads; t++) {
+		Searcher* s = searchers[t];
+		stats.nodes += s->nodes;
+		stats.tableProbes += s->tableProbes;
+		stats.tableHits += s->tableHits;
+		stats.tableStores += s->tableStores;
+		stats.cutoffs += s->cutoffs;
+		stats.firstCutoffs += s->firstCutoffs;
+		evalTime += s->evalTime;
+		genTime += s->genTime;
+	}
+	stats.evalTime = (int) (evalTime / 1000);
+	stats.genTime = (int) (genTime / 1000);
+	statsLock.lock();
+	if (depth > lastIteration.depth) {  // a slower thread may report an older iteration
+		unsigned long long previous = lastNodes[1] - lastNodes[0];
+		stats.branching = previous ? (double) (stats.nodes - lastNodes[1]) / previous : 0;
+		lastNodes[0] = lastNodes[1];
+		lastNodes[1] = stats.nodes;
+		lastIteration = stats;
+		if (iterationCallback) iterationCallback(iterationData, &stats);
+		if (statsLog) {
+			fprintf(statsLog, "{\"depth\": %d, \"move\": [%d, %d], \"price\": %d, \"time_us\": %d, \"nodes\": %llu, "
+				"\"table_probes\": %llu, \"table_hits\": %llu, \"table_stores\": %llu, \"cutoffs\": %llu, "
+				"\"first_cutoffs\": %llu, \"branching\": %.2f, \"eval_us\": %d, \"gen_us\": %d}\n",
+				stats.depth, stats.i, stats.j, stats.price, stats.time, stats.nodes, stats.tableProbes, stats.tableHits,
+				stats.tableStores, stats.cutoffs, stats.firstCutoffs, stats.branching, stats.evalTime, stats.genTime);
+			fflush(statsLog);
+		}
+	}
+	statsLock.unlock();
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::setBook(const char* fileName) {
+	if (!fileName) {
+		book->close();
+		return true;
+	}
+	return book->open(fileName);
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::setWeights(const char* fileName) {
+	return evaluation.load(fileName);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setIterationCallback(IterationCallback callback, void* data) {
+	statsLock.lock();
+	iterationCallback = callback;
+	iterationData = data;
+	statsLock.unlock();
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::setStatsLog(const char* fileName) {
+	statsLock.lock();
+	if (statsLog) fclose(statsLog);
+	statsLog = fileName ? fopen(fileName, "a") : NULL;
+	statsLock.unlock();
+	return !fileName || statsLog;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::getIterationStats(IterationStats* stats) {
+	statsLock.lock();
+	*stats = lastIteration;
+	statsLock.unlock();
+}
+
+template<int numCols, int numRows>
+unsigned long long BasicBrain<numCols, numRows>::positionKey(Field* position) {
+	unsigned long long key = 0;
+	for (int i = 0; i < numCols; i++) {
+		for (int j = 0; j < numRows; j++) {
+			key ^= zobristCodes[i][j][position->at(i, j)];
+		}
+	}
+	return key;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::think(int player, SearchCallback callback, void* data) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	expectI = -1;
+	expectJ = -1;
+	// a book move or a forced win found by the threat-space or the proof-number search needs no further thought
+	if (book->probe(&position, player, &resultI, &resultJ))
+		publish(1, resultI, resultJ, 0);
+	else if (threatSearch->findWin(&position, player, true, THREATNODES)) {
+		resultI = threatSearch->line[0].i;
+		resultJ = threatSearch->line[0].j;
+		// the win needs no iteration of the search, its length is reported apart
+		winLength = threatSearch->length;
+		publish(1, resultI, resultJ, WINSCORE);
+		if (threatSearch->length > 1) {
+			expectI = threatSearch->line[1].i;
+			expectJ = threatSearch->line[1].j;
+		}
+	} else if (proofNodes && solver()->solve(&position, player, player, proofNodes,
+		deadline ? start + (deadline - start) / 2 : 0) == PROVED) {
+		resultI = proofSearch->line[0].i;
+		resultJ = proofSearch->line[0].j;
+		winLength = proofSearch->length;
+		publish(1, resultI, resultJ, WINSCORE);
+		if (proofSearch->length > 1) {
+			expectI = proofSearch->line[1].i;
+			expectJ = proofSearch->line[1].j;
+		}
+	} else {
+		transTable->newSearch();
+		std::thread helpers[MAXTHREADS];
+		for (int t = 1; t < numThreads; t++)
+			helpers[t] = std::thread(&Searcher::search, searchers[t], &position, player);
+		searchers[0]->search(&position, player);
+		stop = true;
+		for (int t = 1; t < numThreads; t++)
+			helpers[t].join();
+		Searcher* best = searchers[0];
+		for (int t = 1; t < numThreads; t++)
+			if (searchers[t]->completedDepth > best->completedDepth)
+				best = searchers[t];
+		resultI = best->bestI;
+		resultJ = best->bestJ;
+		// the expected reply is the hash move of the position after the move
+		Field next = position;
+		next.set(resultI, resultJ, player);
+		TransTable::Entry entry;
+		if (transTable->probe(positionKey(&next) ^ zobristTurn[player][opponent], &entry) && entry.move >= 0
+			&& !next.at(entry.move / numRows, entry.move % numRows)) {
+			expectI = entry.move / numRows;
+			expectJ = entry.move % numRows;
+		}
+	}
+	searching = false;
+	if (callback) callback(data, resultI, resultJ);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::startSearch(int player, int moveTime, SearchCallback callback, void* data) {
+	pondering = false;
+	launch(field, player, moveTime, callback, data);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::launch(Field* position, int player, int moveTime, SearchCallback callback, void* data) {
+	stopWorker();
+	this->position = *position;
+	start = now();
+	deadline = moveTime > 0 ? start + moveTime * 1000LL : 0;
+	for (int d = 0; d <= MAXDEPTH; d++)
+		depthTime[d] = -1;
+	for (int t = 0; t < numThreads; t++)  // a threat win leaves the searchers idle
+		searchers[t]->clearCounters();
+	statsLock.lock();
+	memset(&lastIteration, 0, sizeof(lastIteration));
+	lastIteration.i = lastIteration.j = -1;
+	lastNodes[0] = lastNodes[1] = 0;
+	statsLock.unlock();
+	stop = false;
+	progress = 0xffffULL << 32;     // no move yet
+	winLength = 0;
+	resultI = -1;
+	resultJ = -1;
+	searching = true;
+	worker = std::thread(&BasicBrain::think, this, player, callback, data);
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::ponder(int player) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	if (searching || expectI < 0) return false;
+	if (field->stones != position.stones + 1 || field->at(resultI, resultJ) != player || field->at(expectI, expectJ))
+		return false;
+	Field next = *field;
+	next.set(expectI, expectJ, opponent);
+	if (next.isFive(opponent, expectI, expectJ, NULL, NULL, NULL) || next.frontierSize == 0) return false;
+	ponderI = expectI;
+	ponderJ = expectJ;
+	launch(&next, player, 0, NULL, NULL);
+	pondering = true;
+	return true;
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::ponderHit(int i, int j, int moveTime) {
+	if (!pondering) return false;
+	pondering = false;
+	if (i != ponderI || j != ponderJ) {
+		stopWorker();
+		return false;
+	}
+	deadline = moveTime > 0 ? start + moveTime * 1000LL : 0;
+	return true;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setDeadline(int moveTime) {
+	deadline = moveTime > 0 ? now() + moveTime * 1000LL : 0;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setNodeLimit(unsigned long long nodes) {
+	nodeLimit = nodes;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setDepthLimit(int depth) {
+	depthLimit = (depth > 0 && depth < MAXDEPTH) ? depth : MAXDEPTH;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::setSolver(unsigned long long nodes, int tableSize) {
+	proofNodes = nodes;
+	if (proofSearch && tableSize != proofSize) {
+		delete proofSearch;
+		proofSearch = NULL;
+	}
+	proofSize = tableSize;
+}
+
+template<int numCols, int numRows>
+typename BasicBrain<numCols, numRows>::ProofSearch* BasicBrain<numCols, numRows>::solver() {
+	if (!proofSearch) proofSearch = new ProofSearch(this, proofSize);
+	return proofSearch;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::cancelSearch() {
+	stop = true;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::stopWorker() {
+	cancelSearch();
+	if (worker.joinable())
+		worker.join();
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::isSearching() {
+	return searching;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::getSearchInfo(SearchInfo* info) {
+	unsigned long long p = progress;
+	int move = (int) ((p >> 32) & 0xffff);
+	info->searching = searching;
+	info->pondering = pondering;
+	info->depth = (int) (p >> 56);
+	info->i = move == 0xffff ? -1 : move / numRows;
+	info->j = move == 0xffff ? -1 : move % numRows;
+	info->price = (int) (unsigned) p;
+	info->winLength = winLength;
+	info->nodes = 0;
+	info->tableProbes = 0;
+	info->tableHits = 0;
+	for (int t = 0; t < numThreads; t++) {
+		info->nodes += searchers[t]->nodes;
+		info->tableProbes += searchers[t]->tableProbes;
+		info->tableHits += searchers[t]->tableHits;
+	}
+	info->time = (int) ((now() - start) / 1000);
+	for (int d = 0; d <= MAXDEPTH; d++)
+		info->depthTime[d] = depthTime[d];
+}
+
+template<int numCols, int numRows>
+bool BasicBrain<numCols, numRows>::waitSearch(int* i, int* j) {
+	if (worker.joinable())
+		worker.join();
+	if (resultI < 0) return false;
+	*i = resultI;
+	*j = resultJ;
+	return true;
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::getBestMove(int player, int* i, int* j) {
+	startSearch(player, MOVETIME);
+	waitSearch(i, j);
+}
+
+template<int numCols, int numRows>
+void BasicBrain<numCols, numRows>::solve(int player, unsigned long long nodes, int moveTime, ProofInfo* info) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	ProofSearch* search = solver();
+	long long begin = now();
+	stop = false;                   // left set by the last search
+	info->result = 0;
+	info->length = 0;
+	int result = search->solve(field, player, player, nodes, moveTime > 0 ? now() + moveTime * 1000LL : 0);
+	info->nodes = search->nodes;
+	if (result == PROVED)
+		info->result = player;
+	else {
+		// a win of the opponent is exact even if the search for one of player has not finished
+		int reply = search->solve(field, player, opponent, nodes, moveTime > 0 ? now() + moveTime * 1000LL : 0);
+		info->nodes += search->nodes;
+		if (reply == PROVED) info->result = opponent;
+		else if (reply == DISPROVED && result == DISPROVED) info->result = PROOFDRAW;
+		else if (reply && result) info->result = PROOFNOWINNEAR;  // both disproved, one of them near the stones
+	}
+	if (info->result == CIRCLE || info->result == CROSS) {
+		info->length = search->length;
+		memcpy(info->line, search->line, search->length * sizeof(Cell));
+	}
+	info->time = (int) ((now() - begin) / 1000);
+}
+
+/***********************************************************************************************/
+
+#define INSTANTIATE(cols, rows) \
+	template class BasicField<cols, rows>; \
+	template class BasicSearcher<cols, rows>; \
+	template class BasicThreatSearch<cols, rows>; \
+	template class BasicProofSearch<cols, rows>; \
+	template class BasicBrain<cols, rows>; \
+	template class BasicBatchEvaluator<cols, rows>; \
+	template unsigned long long OpeningBook::canonicalKey(const BasicField<cols, rows>*, int, OpeningBook::Symmetry*); \
+	template bool OpeningBook::probe(const BasicField<cols, rows>*, int, int*, int*); \
+	template bool MoveCursor::next(BasicField<cols, rows>*);
+
+INSTANTIATE(15, 15)
+INSTANTIATE(19, 19)
+INSTANTIATE(20, 20)
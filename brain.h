@@ -0,0 +1,797 @@
+#ifndef BRAIN_H
+#define BRAIN_H
+
+/* the gomoku engine, free of any platform dependency but the mapping of the opening book file */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <limits.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+#define MOVETIME 2500               // default time for a move in ms
+#define MAXDEPTH 20
+#define MAXTHREADS 64               // upper limit of the search threads
+#define THREATNODES 50000           // node budget of the threat-space search before every move
+#define MAXTHREATDEPTH 20           // the longest sequence of threats searched
+#define MAXTHREES 4                 // the most open threes in a sequence of threats
+#define PROOFSIZE (1 << 20)         // entries of the node table of the proof-number search, 24 bytes each
+#define PROOFINF 100000000          // proof or disproof number of a decided node
+#define MAXPROOFDEPTH 60            // plies searched by the proof-number search, a deeper node is not won
+#define PROOFTHREATNODES 200        // node budget of the search for continuous fours at every node
+#define PROOFQUIET 64               // first proof number of a move of the attacker making no four
+#define PROVED 1                    // results of the proof-number search, 0 if it ran out of nodes or time
+#define DISPROVED 2                 // exact, every move was searched
+#define DISPROVEDNEAR 3             // no win by moves near the stones, the others were not searched
+#define PROOFDRAW 4                 // neither side can force a win, see Brain::solve
+#define PROOFNOWINNEAR 5            // neither side can force a win by moves near the stones
+#define WINSCORE 100000000          // value of a won position, above any sum of blocks
+#define INFSCORE (2*WINSCORE)       // bound of the search window, safe to negate
+#define ASPIRATION 1000             // half width of the first aspiration window
+#define ROOTNOISE 30                // default range of the random bonus of the root moves, see Brain::setNoise
+#define ORDERSCALE 1024             // moves are ordered by threat score first, killers and history break the ties
+#define NUMROWS 20                  // the board of Field and Brain, BasicField and BasicBrain take any other
+#define NUMCOLS 20
+#define NUMBLOCKS 26
+#define BLOCKWINDOW 7               // cells covered by one entry of the compiled block table
+#define TRANSSIZE 1600451           // transposition table size
+#define EXACT 0                     // bound types of transposition table entries
+#define LOWERBOUND 1
+#define UPPERBOUND 2
+#define BOOKPLIES 12                // positions with at most this many stones are kept in the opening book
+#define BOOKMINGAMES 2              // games a book move needs to be played
+#define BATCHLANES 8                // positions evaluated together by BatchEvaluator, one per lane of a 256-bit vector
+#define CIRCLE 1                    // token for a circle
+#define CROSS 2                     // token for a cross
+/* define SEARCHPROFILE to measure the time spent in the evaluation and the move generation,
+   it costs two clock reads per call and is left out of release builds */
+
+/***********************************************************************************************/
+
+struct Cell {
+	int i;
+	int j;
+};
+
+/* the numbers 0 to n - 1 as template arguments, MakeIndices<n>::Type, built in log n steps */
+template<int... k> struct IndexList {};
+template<class A, class B> struct JoinIndices;
+template<int... a, int... b> struct JoinIndices<IndexList<a...>, IndexList<b...> > {
+	typedef IndexList<a..., (int) sizeof...(a) + b...> Type;
+};
+template<int n> struct MakeIndices {
+	typedef typename JoinIndices<typename MakeIndices<n / 2>::Type, typename MakeIndices<n - n / 2>::Type>::Type Type;
+};
+template<> struct MakeIndices<0> { typedef IndexList<> Type; };
+template<> struct MakeIndices<1> { typedef IndexList<0> Type; };
+
+/* every row, column and diagonal of a numCols by numRows field, numbered rows first, then the columns,
+   the diagonals and the anti-diagonals; each one in a single expression, so that the tables of the
+   lines are filled by the compiler */
+template<int numCols, int numRows> struct LineGeometry {
+	enum {
+		numLines = numRows + numCols + 2*(numCols + numRows - 1),  // rows, columns and both diagonals
+		maxLine = numCols > numRows ? numCols : numRows             // the longest line
+	};
+	static constexpr int min(int a, int b) { return a < b ? a : b; }
+	static constexpr int stepI(int d) { return d == 0 || d == 2 ? 1 : d == 3 ? -1 : 0; }
+	static constexpr int stepJ(int d) { return d == 0 ? 0 : 1; }
+	static constexpr int first(int d) {     // the first line of direction d
+		return d == 0 ? 0 : d == 1 ? numRows : d == 2 ? numRows + numCols : 2*(numRows + numCols) - 1;
+	}
+	static constexpr int direction(int line) {
+		return line < first(1) ? 0 : line < first(2) ? 1 : line < first(3) ? 2 : 3;
+	}
+	static constexpr int startI(int line) { // the first cell of line
+		return direction(line) == 0 ? 0 :
+			direction(line) == 1 ? line - first(1) :
+			direction(line) == 2 ? (line - first(2) < numRows ? 0 : line - first(2) - numRows + 1) :
+			(line - first(3) < numCols ? line - first(3) : numCols - 1);
+	}
+	static constexpr int startJ(int line) {
+		return direction(line) == 0 ? line :
+			direction(line) == 1 ? 0 :
+			direction(line) == 2 ? (line - first(2) < numRows ? line - first(2) : 0) :
+			(line - first(3) < numCols ? 0 : line - first(3) - numCols + 1);
+	}
+	static constexpr int length(int line) {
+		return direction(line) == 0 ? numCols :
+			direction(line) == 1 ? numRows :
+			direction(line) == 2 ? min(numCols - startI(line), numRows - startJ(line)) :
+			min(startI(line) + 1, numRows - startJ(line));
+	}
+	static constexpr Cell cell(int line, int pos) {  // 0,0 past the end of the line
+		return pos < length(line) ? Cell{startI(line) + pos*stepI(direction(line)), startJ(line) + pos*stepJ(direction(line))} :
+			Cell{0, 0};
+	}
+	static constexpr int startingAt(int i, int j, int d) {  // the line of direction d starting on i,j
+		return d == 0 ? j : d == 1 ? first(1) + i :
+			d == 2 ? first(2) + (i == 0 ? j : numRows + i - 1) :
+			first(3) + (j == 0 ? i : numCols - 1 + j);
+	}
+	static constexpr int position(int i, int j, int d) {  // of i,j within its line of direction d
+		return d == 0 ? i : d == 1 ? j : d == 2 ? min(i, j) : min(numCols - 1 - i, j);
+	}
+	static constexpr int lineOf(int i, int j, int d) {
+		return startingAt(i - position(i, j, d)*stepI(d), j - position(i, j, d)*stepJ(d), d);
+	}
+};
+
+template<int numCols, int numRows,
+	class Lines = typename MakeIndices<LineGeometry<numCols, numRows>::numLines>::Type,
+	class LineCells = typename MakeIndices<LineGeometry<numCols, numRows>::numLines*
+		LineGeometry<numCols, numRows>::maxLine>::Type,
+	class FieldCells = typename MakeIndices<numCols*numRows*4>::Type>
+struct LineTables;
+
+template<int numCols, int numRows, int... line, int... cell, int... k>
+struct LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> > : LineGeometry<numCols, numRows> {
+	typedef LineGeometry<numCols, numRows> G;
+	static constexpr int lineLength[G::numLines] = {G::length(line)...};
+	static constexpr int lineDirection[G::numLines] = {G::direction(line)...};
+	static constexpr Cell lineCells[G::numLines][G::maxLine] = {G::cell(cell / G::maxLine, cell % G::maxLine)...};
+	static constexpr int lineOf[numCols][numRows][4] = {G::lineOf(k / (4*numRows), k / 4 % numRows, k % 4)...};
+	static constexpr int linePos[numCols][numRows][4] = {G::position(k / (4*numRows), k / 4 % numRows, k % 4)...};
+};
+
+template<int numCols, int numRows, int... line, int... cell, int... k>
+constexpr int LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> >::lineLength[];
+template<int numCols, int numRows, int... line, int... cell, int... k>
+constexpr int LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> >::lineDirection[];
+template<int numCols, int numRows, int... line, int... cell, int... k>
+constexpr Cell LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> >::lineCells[][G::maxLine];
+template<int numCols, int numRows, int... line, int... cell, int... k>
+constexpr int LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> >::lineOf[][numRows][4];
+template<int numCols, int numRows, int... line, int... cell, int... k>
+constexpr int LineTables<numCols, numRows, IndexList<line...>, IndexList<cell...>, IndexList<k...> >::linePos[][numRows][4];
+
+/* the playing field consisting of crosses and circles, numCols by numRows cells; the sizes are
+   constants of each instance, so the compiler sees every loop bound and table size */
+template<int numCols, int numRows> class BasicField : LineTables<numCols, numRows> {
+public:
+	typedef ::Cell Cell;
+	enum {
+		numLines = LineGeometry<numCols, numRows>::numLines,  // rows, columns and both diagonals
+		maxLine = LineGeometry<numCols, numRows>::maxLine,    // the longest line
+		lineWords = (numLines + 7) & ~7, // numLines rounded up to whole 256-bit vectors
+		packedSize = (2*numCols*numRows + 7) / 8  // bytes of a position packed by pack
+	};
+private:
+	/* one bit per cell for every row, column and diagonal: bits[CIRCLE] and bits[CROSS] hold
+	   the stones of each player, bits[0] all occupied cells; bit k is the k-th cell of the line */
+	unsigned bits[3][lineWords];
+	unsigned pernament[numRows];    // bit i of word j is set for pernament stones on i,j
+	unsigned char neighbours[numCols][numRows];  // number of occupied cells around i,j
+	typedef LineTables<numCols, numRows> Tables;
+public:
+	/* every row, column and diagonal of the field as a sequence of cells, constants of the instance */
+	using Tables::lineLength;
+	using Tables::lineDirection;       // 0 horizontal, 1 vertical, 2 diagonal, 3 anti-diagonal
+	using Tables::lineCells;
+	using Tables::lineOf;              // the line passing through i,j in each of the 4 directions
+	using Tables::linePos;             // position of i,j within that line
+	BasicField();
+	int at(int i, int j) const;     // returns item on index i,j (0 outside of the field)
+	void set(int i, int j, int item);
+	bool isPernament(int i, int j);
+	void setPernament(int i, int j, bool pernament);
+	int lineItem(int line, int pos);  // returns item on position pos of line
+	unsigned lineBits(int line, int item);  // cells of line holding item, bit k for position k
+	int stones;                     // number of occupied cells
+	int frontierSize;               // number of empty cells with an occupied neighbour
+	Cell frontier[numCols*numRows]; // those cells in no particular order
+	short frontierIndex[numCols][numRows];  // position of i,j in frontier
+	bool isFrontier(int i, int j);  // check if [i,j] is empty and has an occupied neighbour
+	void addFrontier(int i, int j);
+	void removeFrontier(int i, int j);
+	int findFive(int player);       // returns a line with five stones of player in a row, -1 if there is none
+	unsigned fiveMask(int line, int player);  // bit k is set if five stones of player start on position k of line
+	/* check five stones of player passing through [i,j], return where they start and their direction */
+	bool isFive(int player, int i, int j, int* vi, int* vj, int* direction);
+	/* store the stones with 2 bits per cell (0 empty, CIRCLE, CROSS), cell i,j at bit pair j*numCols+i,
+	   into packedSize bytes */
+	void pack(unsigned char* packed) const;
+	void unpack(const unsigned char* packed);  // put the stones of a packed position on the field
+};
+
+/***********************************************************************************************/
+
+unsigned long long splitMix64(unsigned long long* state);  // the next 64 random bits of state
+/* the random bonus of a root move below noise, hashed from key, that of the root combined with the code of the
+   move; 0 once a bound of the window alpha..beta is a win or a loss */
+int noiseBonus(unsigned long long key, int noise, int alpha, int beta);
+/* the threat score of a cell in one direction, own and other being the runs of stones of the player and of the
+   opponent touching it there, at most 4 */
+int runScore(int own, int other);
+
+class TransTable {                  // the transposition table, kept for the whole game and shared by all threads
+public:
+	struct Entry {
+		unsigned long long key;
+		int value;
+		short move;                 // i*NUMROWS+j of the best move, -1 if unknown
+		unsigned char depth;        // the remaining depth the value was searched to
+		unsigned char flags;        // bound type in the lower 2 bits, age of the entry in the rest
+	};
+private:
+	/* the entry packed into data; check is key ^ data, so that an entry torn by
+	   two threads writing at once does not verify and is ignored without any locking */
+	struct Slot {
+		std::atomic<unsigned long long> check;
+		std::atomic<unsigned long long> data;
+	};
+	Slot* slots;
+	int size;
+	std::atomic<unsigned char> age; // incremented by every search, by the engines sharing the table too
+public:
+	TransTable(int size);
+	~TransTable();
+	static int sizeFor(long long bytes);  // the number of entries which fit into bytes of memory
+	void clear();
+	void newSearch();
+	bool probe(unsigned long long key, Entry* entry);
+	void store(unsigned long long key, int depth, int bound, int value, int move);
+};
+
+/***********************************************************************************************/
+
+class Evaluation {                  // the pay-off of the blocks of stones on a line, shared by every board
+public:
+	struct Block {
+		char string[10];
+		int value;
+	} blocks[NUMBLOCKS];
+	int maxBlockLength;  // the longest block without the terminating '$'
+	/* summed value of all blocks starting at the first cell of a window of BLOCKWINDOW cells,
+	   for CIRCLE and CROSS; the window is encoded by 2 bits per cell (0 empty, CIRCLE, CROSS, 3 off the field) */
+	int blockTable[1 << (2*BLOCKWINDOW)][3];
+	/* number of blocks which are open threes (three stones, no opponent, empty on both ends)
+	   starting at the first cell of the window, encoded as in blockTable */
+	unsigned char threeTable[1 << (2*BLOCKWINDOW)][3];
+	Evaluation();
+	void compile();             // fill blockTable and threeTable from blocks
+	bool matches(int k, int code, int player);  // block k starts at the first cell of the window code for player
+	/* read the values of the blocks from fileName, one "value "block"" per line as written by save, and compile
+	   them; the blocks not listed keep their value, nothing is changed if the file cannot be read */
+	bool load(const char* fileName);
+	bool save(const char* fileName);
+};
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows> class BasicBrain;
+
+template<int numCols, int numRows> class BasicSearcher {  // a single search thread with its own copy of the field
+	typedef BasicField<numCols, numRows> Field;
+	typedef BasicBrain<numCols, numRows> Brain;
+	friend class EvalTest;          // checks the compiled blocks against their strings
+	Brain* brain;
+	int index;                      // 0 for the worker thread of Brain, the helpers follow
+	Field field;
+	unsigned long long zobristKey;
+	int rootPlayer;             // the player the search computes the best move for
+	bool timeout;               // the search has run out of time, its results are not valid
+	bool followPV;              // the current path is the principal variation of the previous iteration
+	Cell lastPV[MAXDEPTH+1];  // the principal variation of the previous iteration
+	int lastPVLength;
+	Cell killers[MAXDEPTH+1][2];  // the last two quiet moves which caused a cutoff on each depth
+	int history[3][numCols][numRows];    // how often a move of player caused a cutoff, weighted by the depth left
+	struct Move {
+		int i;
+		int j;
+		int score;
+	};
+	int lineScore[Field::numLines][3];  // cached pay-off of every line for CIRCLE and CROSS
+	int totalScore[3];           // sum of lineScore over all lines
+	/* add the pay-off of the blocks starting at positions from..to of a line to score[CIRCLE] and score[CROSS] */
+	void scoreLine(int line, int from, int to, int* score);
+	void updateLines(int i, int j, int item);  // put item on [i,j] and re-score the four lines passing through it
+	void initLineScores();
+	void initZobristKey();      // compute zobristKey of the position on the field
+	void makeMove(int i, int j, int player);
+	void unmakeMove(int i, int j, int player);
+	int payOff(int player);  // compute the pay-off for player
+	/* the random bonus of the root move [i,j] searched within alpha..beta, the key must be that of the root */
+	int rootNoise(int i, int j, int alpha, int beta);
+	int threatScore(int player, int i, int j);  // cheap estimate of how good [i,j] is for player
+	int generateMoves(int player, int depth, Move* moves);  // the admissible moves, most promising first
+	void addCutoff(int player, int depth, int maxDepth, int i, int j);  // update killers and history
+	void promoteMove(Move* moves, int numMoves, int i, int j);  // move [i,j] to the front of moves
+	/* won positions are stored with their distance from the node instead of the root */
+	int valueToTable(int value, int depth);
+	int tableToValue(int value, int depth);
+public:
+	int bestI;
+	int bestJ;  // the best position computed by the algorithm
+	int bestPrice;
+	int completedDepth;         // the deepest iteration finished before the search was stopped
+	/* triangular table of principal variations: pv[depth][depth..pvLength[depth]-1] is the best line
+	   found from the node on depth, so pv[0] is the expected continuation of the game */
+	Cell pv[MAXDEPTH+1][MAXDEPTH+1];
+	int pvLength[MAXDEPTH+1];
+	std::atomic<unsigned long long> nodes;  // nodes visited by the current search
+	std::atomic<unsigned long long> tableProbes;
+	std::atomic<unsigned long long> tableHits;
+	std::atomic<unsigned long long> tableStores;
+	std::atomic<unsigned long long> cutoffs;       // nodes which failed high
+	std::atomic<unsigned long long> firstCutoffs;  // nodes which failed high on their first move
+	std::atomic<long long> evalTime;    // ns spent in payOff, only with SEARCHPROFILE
+	std::atomic<long long> genTime;     // ns spent in generateMoves, only with SEARCHPROFILE
+	BasicSearcher(Brain* brain, int index);
+	void clearHistory();        // forget the killers and the history of the previous games
+	void clearCounters();       // zero the nodes and the statistics before a search
+	/* iterative deepening on position until the time is up or the search is stopped */
+	void search(const Field* position, int player);
+	/* one iteration to maxDepth in an aspiration window around the expected value, INFSCORE if unknown */
+	int iterate(int player, int maxDepth, int value);
+	/* negamax principal variation search with alpha-beta prunning, the value is seen by player to move */
+	int pvs(int player, int depth, int maxDepth, int alpha, int beta);
+};
+
+/***********************************************************************************************/
+
+/* the static evaluation of many positions at once, for analysis and tuning; it is the pay-off the search
+   sees at its leaves, without any search */
+template<int numCols, int numRows> class BasicBatchEvaluator {
+	typedef BasicField<numCols, numRows> Field;
+	int numThreads;
+	short lineIndex[Field::numLines][Field::maxLine];  // j*numCols+i of every cell of every line
+	/* evaluate count <= BATCHLANES positions, one per lane */
+	void evaluateGroup(const unsigned char* positions, int count, const unsigned char* players, int* values);
+	void evaluateRange(const unsigned char* positions, const unsigned char* players, int* values, int from, int to);
+public:
+	Evaluation evaluation;      // the blocks may be changed, then compiled again
+	BasicBatchEvaluator();
+	void setThreads(int n);     // split the batches among n threads
+	/* values[k] = the pay-off of position k for players[k], or for the player to move (a cross first) if
+	   players is NULL; position k is packedSize bytes at positions + k*packedSize, see Field::pack */
+	void evaluate(const unsigned char* positions, int n, const unsigned char* players, int* values);
+};
+
+/***********************************************************************************************/
+
+/* searches for a forced win by a sequence of threats (VCF and VCT) */
+template<int numCols, int numRows> class BasicThreatSearch {
+	typedef BasicField<numCols, numRows> Field;
+	typedef BasicBrain<numCols, numRows> Brain;
+	Brain* brain;
+	Field field;
+	int attacker;
+	int defender;
+	int nodes;
+	int maxNodes;
+	unsigned char mark[numCols][numRows];  // marks cells already collected by the move generators
+	unsigned char markStamp;
+	int threeCount(int i, int j);   // number of open threes of the attacker in the lines through [i,j]
+	/* the cells completing five stones of player in the lines through [i,j], at most max of them */
+	int completions(int player, int i, int j, Cell* cells, int max);
+	bool hasCompletion(int player); // check if player can make five with his next stone
+	/* the empty cells of all windows of five holding need stones of player and none of the opponent */
+	int collectMoves(int player, int need, Cell* cells);
+	void startMark();
+	bool attack(int depth, int threes);  // threes is the number of open threes the attacker may still play
+public:
+	int length;                     // number of moves in line
+	Cell line[2*MAXTHREATDEPTH + 1];  // the winning sequence, attacker and defender moves alternating
+	BasicThreatSearch(Brain* brain);
+	/* search for a win of player by continuous fours only (VCF), or by fours and open threes (VCT) */
+	bool findWin(const Field* position, int player, bool threes, int maxNodes);
+};
+
+/***********************************************************************************************/
+
+/* proves or disproves a forced win by depth-first proof-number search (df-pn); the numbers are kept for the
+   player to move: phi is 0 once he has reached his goal, delta once he cannot, the goal of the attacker
+   being five stones and that of the defender not letting him make them; the attacker plays the cells at
+   most two steps from a stone and the defender every empty cell, the near ones first, so a proof holds
+   against any defence, and a disproof is exact only if no attack was left out, else it holds for the
+   attacks near the stones */
+template<int numCols, int numRows> class BasicProofSearch {
+	typedef BasicField<numCols, numRows> Field;
+	typedef BasicBrain<numCols, numRows> Brain;
+	typedef BasicThreatSearch<numCols, numRows> ThreatSearch;
+	struct Entry {
+		unsigned long long key;
+		unsigned phi;
+		unsigned delta;
+		unsigned work;              // nodes expanded below the entry, of two entries the one with less is replaced
+		short move;                 // i*numRows+j of the child searched last, or of the move ending the game
+		unsigned char age;          // the solve which stored the entry, those of earlier ones are free
+	};
+	Brain* brain;
+	Field field;
+	ThreatSearch* threatSearch;     // finds the wins by continuous fours at the leaves
+	Entry* table;                   // buckets of two entries
+	int size;
+	unsigned char age;              // incremented by every solve, the table is only cleared when it wraps
+	int attacker;
+	unsigned long long maxNodes;
+	long long deadline;             // us of the steady clock, 0 for none
+	bool aborted;                   // the nodes or the time have run out
+	bool limited;                   // a node was cut off at MAXPROOFDEPTH
+	bool restricted;                // the moves of an attacker were only the cells near the stones
+	Cell* children;                 // numCols*numRows moves for every ply, kept off the stack of the search thread
+	unsigned* childPhi;             // and their numbers
+	unsigned* childDelta;
+	Entry* probe(unsigned long long key);
+	void store(unsigned long long key, unsigned phi, unsigned delta, unsigned long long work, int move);
+	/* the distinct cells completing five stones of player, at most max of them */
+	int completions(int player, Cell* cells, int max);
+	/* bit i of near[j] for the empty cells at most two steps from a stone in one of the 8 directions */
+	void nearCells(unsigned* near);
+	/* the open windows of five through [i,j] for ordering the moves, threat is the most stones of player in
+	   one of them */
+	int moveScore(int player, int i, int j, int* threat);
+	/* the moves of player on depth and the first delta of each child in childDelta, -1 for a decided node
+	   with its numbers and the move ending the game */
+	int generateMoves(int player, int depth, Cell* moves, unsigned* phi, unsigned* delta, int* move);
+	unsigned long long childKey(unsigned long long key, int player, Cell move);
+	/* expand the node until its phi reaches thPhi or its delta thDelta */
+	void mid(unsigned long long key, int player, int depth, unsigned thPhi, unsigned thDelta);
+	void findLine(unsigned long long key, int player);  // follow the proof from the root into line
+public:
+	unsigned long long nodes;       // expanded by the last solve
+	int length;                     // number of moves in line
+	Cell line[MAXPROOFDEPTH + 1];   // the proved win, both sides alternating from the root
+	BasicProofSearch(Brain* brain, int size = PROOFSIZE);
+	~BasicProofSearch();
+	static int sizeFor(long long bytes);  // the number of entries which fit into bytes of memory
+	/* try to prove that attacker wins on position with player to move: PROVED, DISPROVED, DISPROVEDNEAR or
+	   0; the search stops after maxNodes (0 for no limit), at deadline in us of the steady clock (0 for none)
+	   or when the brain is stopped */
+	int solve(const Field* position, int player, int attacker, unsigned long long maxNodes, long long deadline);
+};
+
+/***********************************************************************************************/
+
+class MappedFile {                  // a whole file mapped into memory for reading
+public:
+	const unsigned char* data;      // NULL if no file is mapped
+	size_t size;
+	MappedFile();
+	~MappedFile();
+	bool open(const char* fileName);  // false if the file cannot be mapped or is empty
+	void close();
+private:
+	void* fileHandle;               // the handles of the mapping, Windows only
+	void* mapHandle;
+};
+
+/***********************************************************************************************/
+
+class OpeningBook {                 // move statistics of opening positions, read from a memory-mapped file
+public:
+	/* positions are reduced to a canonical form: the stones of the player to move and of his opponent,
+	   turned and mirrored by one of the 8 symmetries of the square and shifted to the corner */
+	struct Symmetry {
+		int transform;              // bit 0 swaps the coordinates, bit 1 negates i, bit 2 negates j
+		int offI;
+		int offJ;                   // subtracted after the transform
+	};
+	struct Entry {                  // one move from one position, the file is sorted by key and move
+		unsigned long long key;
+		short i;
+		short j;                    // the move in canonical coordinates
+		unsigned games;
+		unsigned wins;              // of the player making the move
+		unsigned draws;
+	};
+	OpeningBook();
+	~OpeningBook();
+	bool open(const char* fileName);  // map the book, false if it is not valid
+	void close();
+	int size();
+	/* key of the canonical form of position with player to move and the symmetry leading to it,
+	   0 if the position has more than BOOKPLIES stones */
+	template<int numCols, int numRows>
+	static unsigned long long canonicalKey(const BasicField<numCols, numRows>* position, int player, Symmetry* symmetry);
+	static void toCanonical(const Symmetry* symmetry, int i, int j, int* ci, int* cj);
+	static void fromCanonical(const Symmetry* symmetry, int ci, int cj, int* i, int* j);
+	/* the best scored move played at least BOOKMINGAMES times, false if there is none */
+	template<int numCols, int numRows>
+	bool probe(const BasicField<numCols, numRows>* position, int player, int* i, int* j);
+	/* sort entries, merge those of the same position and move and write them as a book */
+	static bool write(const char* fileName, Entry* entries, int n);
+private:
+	const Entry* entries;
+	int numEntries;
+	MappedFile file;
+	static void transform(int t, int i, int j, int* u, int* v);
+};
+
+/***********************************************************************************************/
+
+/* a game record file is RECORDMAGIC followed by the games one after another, each a RecordHeader and its
+   moves: one byte per move holding the step from the previous move (from the centre for the first one)
+   as 16*(di + 8) + dj + 8, or 0 and the cell j*cols + i in two bytes for a longer step; with RECORDSCORES
+   every move is followed by the score of its search (4 bytes) and the depth reached (1 byte); the moves are
+   padded with zeros to a multiple of 4 bytes, so that every header is aligned in the mapped file */
+#define RECORDMAGIC "GMKGAME1"
+#define RECORDSCORES 1              // flags of RecordHeader
+#define RECORDCIRCLEFIRST 2         // the circles made the first move, else the crosses
+#define RECORDDRAW 3                // result of a drawn game, 0 for an unfinished one
+#define RECORDSIZE (32*32*8)        // bytes of the moves of a game on the largest board, 32 by 32
+#define RECORDBUFFER (1 << 20)      // write buffer of RecordWriter
+
+struct RecordEngine {               // how one side was played, 0 for no limit or not known
+	unsigned moveTime;              // ms per move
+	unsigned nodes;                 // per move and thread
+	unsigned short threads;
+	unsigned short depth;
+};
+
+struct RecordHeader {
+	unsigned char cols;
+	unsigned char rows;
+	unsigned char result;           // the winner, RECORDDRAW or 0
+	unsigned char flags;
+	unsigned short numMoves;
+	unsigned short size;            // bytes of the moves with the padding
+	RecordEngine engines[2];        // of the crosses and of the circles
+};
+
+class GameRecord {                  // a game being recorded move by move for RecordWriter
+	int lastI;
+	int lastJ;
+public:
+	RecordHeader header;
+	unsigned char moves[RECORDSIZE];
+	GameRecord();
+	/* start a game on a cols by rows board with first to move, an engine is NULL for a human player */
+	void start(int cols, int rows, int first, const RecordEngine* crosses, const RecordEngine* circles, bool scores);
+	void add(int i, int j, int score = 0, int depth = 0);
+	void finish(int result);        // the winner or RECORDDRAW
+};
+
+class RecordWriter {                // appends games to a record file, safe to share between threads
+	FILE* file;
+	std::mutex lock;
+public:
+	RecordWriter();
+	~RecordWriter();
+	/* append to fileName or create it, false if it is not a record file; an incomplete game at its end,
+	   left by a writer which did not close the file, is cut off */
+	bool open(const char* fileName);
+	bool write(const GameRecord* game);  // buffered, see flush
+	bool flush();
+	bool close();                   // false if some game could not be written
+};
+
+struct RecordedGame {               // a game of a record file, pointing into the mapping
+	const RecordHeader* header;
+	const unsigned char* moves;
+};
+
+class RecordReader {                // iterates over the games of a memory-mapped record file without copying them
+	MappedFile file;
+	size_t position;                // of the next game
+	size_t end;                     // of the last complete game
+	int numGames;
+	bool valid(size_t offset);      // a complete game starts at offset
+public:
+	RecordReader();
+	bool open(const char* fileName);  // map the file, false if it is not a record file
+	void close();
+	int size();                     // the complete games, an incomplete last one is left out
+	bool complete();                // the file has no incomplete game at its end
+	size_t validSize();             // bytes up to the end of the last complete game
+	void rewind();
+	bool next(RecordedGame* game);  // the next game, false after the last one
+};
+
+class MoveCursor {                  // the moves of a recorded game one after another
+	const unsigned char* data;
+	const unsigned char* end;
+	int cols;
+	int rows;
+	int numMoves;
+	bool scores;
+public:
+	int number;                     // moves read so far
+	int i;
+	int j;                          // the last move read
+	int player;                     // who made it
+	int score;
+	int depth;                      // of its search, 0 if the game has no scores
+	MoveCursor(const RecordedGame* game);
+	bool next();                    // read the next move, false after the last one or at broken data
+	/* read the next move and play it on field, false also if the move does not fit */
+	template<int numCols, int numRows>
+	bool next(BasicField<numCols, numRows>* field);
+};
+
+/***********************************************************************************************/
+
+struct SearchInfo {                 // progress of a search, see Brain::getSearchInfo
+	bool searching;                 // false once the search has finished
+	bool pondering;                 // the search is on the opponent's time, see Brain::ponder
+	int depth;                      // the deepest iteration finished by any thread
+	int i;
+	int j;                          // best move of that iteration, -1 before the first one
+	int price;
+	int winLength;                  // plies of the forced win found by the threat or the proof search, 0 if none
+	unsigned long long nodes;       // nodes visited by all threads
+	unsigned long long tableProbes; // transposition table lookups of all threads
+	unsigned long long tableHits;   // lookups which found their position
+	int time;                       // ms since the search started
+	int depthTime[MAXDEPTH+1];      // us from the start until each depth was first finished, -1 if it was not
+};
+
+/* called by the worker thread with the move found once the search has finished */
+typedef void (*SearchCallback)(void* data, int i, int j);
+
+struct IterationStats {             // the search when an iteration was first finished by any thread
+	int depth;
+	int i;
+	int j;                          // best move of the iteration
+	int price;
+	int time;                       // us since the search started
+	unsigned long long nodes;       // visited by all threads since the search started
+	unsigned long long tableProbes;
+	unsigned long long tableHits;
+	unsigned long long tableStores;
+	unsigned long long cutoffs;     // nodes which failed high
+	unsigned long long firstCutoffs;  // of those, the ones which failed high on the first move
+	double branching;               // nodes since the previous iteration divided by the nodes before it
+	int evalTime;                   // us spent in payOff by all threads, 0 without SEARCHPROFILE
+	int genTime;                    // us spent in generateMoves by all threads, 0 without SEARCHPROFILE
+};
+
+/* called by the thread which has finished an iteration first, see Brain::setIterationCallback */
+typedef void (*IterationCallback)(void* data, const IterationStats* stats);
+
+struct ProofInfo {                  // the outcome of Brain::solve
+	/* the player who can force a win against any defence, PROOFDRAW if neither can at all, PROOFNOWINNEAR if
+	   neither can by moves near the stones, 0 if not decided */
+	int result;
+	int length;
+	Cell line[MAXPROOFDEPTH + 1];   // the win from the position on, the winner against the best defence
+	unsigned long long nodes;
+	int time;                       // ms
+};
+
+/***********************************************************************************************/
+
+template<int numCols, int numRows> class BasicBrain {
+	typedef BasicField<numCols, numRows> Field;
+	typedef BasicSearcher<numCols, numRows> Searcher;
+	typedef BasicThreatSearch<numCols, numRows> ThreatSearch;
+	typedef BasicProofSearch<numCols, numRows> ProofSearch;
+	friend class BasicSearcher<numCols, numRows>;
+	friend class BasicThreatSearch<numCols, numRows>;
+	friend class BasicProofSearch<numCols, numRows>;
+	friend class EvalTest;
+	Evaluation evaluation;
+	Field* field;
+	Field position;             // the copy of field the running search started from
+	TransTable* transTable;
+	bool ownTable;              // the table was allocated by the engine, not passed to it
+	Searcher* searchers[MAXTHREADS];
+	int numThreads;
+	ThreatSearch* threatSearch;
+	ProofSearch* proofSearch;   // allocated with its table when it is first needed
+	unsigned long long proofNodes;  // of the proof-number search before every search, 0 for none
+	int proofSize;
+	ProofSearch* solver();
+	OpeningBook* book;
+	std::thread worker;         // the thread running the search started by startSearch
+	std::atomic<bool> searching;
+	std::atomic<bool> stop;     // set when the search is cancelled or the worker has finished, the helpers follow
+	long long start;            // time the search started, in us of the steady clock
+	std::atomic<long long> deadline;  // time the search has to stop, 0 for none
+	unsigned long long nodeLimit;     // nodes each thread may search, 0 for no limit
+	int depthLimit;             // the last iteration of the search
+	int noise;                  // range of the random bonus of the root moves, 0 for none
+	std::atomic<int> depthTime[MAXDEPTH+1];  // see SearchInfo
+	/* the deepest finished iteration of any thread: depth << 56 | move << 32 | price */
+	std::atomic<unsigned long long> progress;
+	std::atomic<int> winLength;     // see SearchInfo
+	std::mutex statsLock;       // guards the members below, iterations may finish on several threads at once
+	IterationStats lastIteration;
+	unsigned long long lastNodes[2];  // nodes at the end of the previous two iterations
+	IterationCallback iterationCallback;
+	void* iterationData;
+	FILE* statsLog;
+	void recordIteration(int depth, int i, int j, int price);  // fill lastIteration and pass it on
+	int resultI;
+	int resultJ;
+	int expectI;
+	int expectJ;                // the reply to resultI, resultJ expected by the search, -1 if unknown
+	bool pondering;
+	int ponderI;
+	int ponderJ;                // the reply the pondering search has assumed
+	static long long now();     // us of the steady clock
+	bool timeUp();              // check if the search was cancelled or its deadline has passed
+	void publish(int depth, int i, int j, int price);  // report a finished iteration to getSearchInfo
+	void think(int player, SearchCallback callback, void* data);  // the body of the worker thread
+	/* start the worker thread on a copy of position, see startSearch */
+	void launch(Field* position, int player, int moveTime, SearchCallback callback, void* data);
+	unsigned long long positionKey(Field* position);  // zobrist code of the stones on position
+	void stopWorker();          // cancel the running search and wait for its thread
+	void init(Field* field, TransTable* table);
+public:
+	unsigned long long zobristCodes[numCols][numRows][3];
+	unsigned long long zobristTurn[3][3];  // codes for the root player and the player to move
+	BasicBrain(Field* field, int transSize = TRANSSIZE);
+	/* an engine searching with table, which other engines may share to save memory; the table is kept
+	   when the engine is deleted and cleared by setSeed and initTransTable, the engines sharing it should
+	   have the same seed so that they find each other's positions */
+	BasicBrain(Field* field, TransTable* table);
+	~BasicBrain();
+	/* search with n threads sharing the transposition table, not to be called while searching */
+	void setThreads(int n);
+	/* start searching the best move for player on the field in a worker thread and return at once;
+	   the search stops after moveTime ms (never if moveTime is 0) or when it is cancelled, then the move
+	   is passed to callback if one is given; a search which is still running is cancelled first */
+	void startSearch(int player, int moveTime, SearchCallback callback = NULL, void* data = NULL);
+	void setDeadline(int moveTime);  // let the running search stop moveTime ms from now, 0 for never
+	void setNodeLimit(unsigned long long nodes);  // stop the next searches after nodes per thread, 0 for no limit
+	void setDepthLimit(int depth);  // stop the next searches after the iteration to depth, 0 for MAXDEPTH
+	/* before the next searches let the proof-number search try to prove a win with at most nodes in a table of
+	   tableSize entries, after the threat-space search and in at most half the time of the move; 0 nodes for
+	   none, the default; not to be called while searching */
+	void setSolver(unsigned long long nodes, int tableSize = PROOFSIZE);
+	/* seed the zobrist codes and with them the random choice among the root moves; a search with one
+	   thread and a node or depth limit is then a function of the seed, the position and the transposition
+	   table, which this clears */
+	void setSeed(unsigned long long seed);
+	/* the root moves get a bonus below amount, drawn from the seed and the position, so that the engine
+	   varies its play among moves of nearly the same value; 0 always plays the best one */
+	void setNoise(int amount);
+	void cancelSearch();        // stop the running search, it still reports the best move found so far
+	bool isSearching();
+	void getSearchInfo(SearchInfo* info);
+	/* play the moves of the opening book in fileName before searching, NULL to close it;
+	   not to be called while searching */
+	bool setBook(const char* fileName);
+	/* let callback be called with the statistics of every iteration of the next searches, NULL for none;
+	   it runs on a search thread and should return quickly */
+	void setIterationCallback(IterationCallback callback, void* data);
+	/* append the statistics of every iteration as one line of JSON to fileName, NULL to stop */
+	bool setStatsLog(const char* fileName);
+	/* the statistics of the last iteration finished, depth 0 before the first one */
+	void getIterationStats(IterationStats* stats);
+	/* use the values of the blocks in fileName, written by the tuner, see Evaluation::load; not to be called
+	   while searching */
+	bool setWeights(const char* fileName);
+	/* after player has played the move of the last search, go on searching his answer to the reply the
+	   search expects, with no deadline; false if no reply is expected or the field has changed since */
+	bool ponder(int player);
+	/* the opponent has played [i,j]: if that is the reply the pondering search assumed, let it continue as
+	   the search for the next move, with moveTime ms counted from the start of pondering, and return true;
+	   otherwise stop pondering and return false, the next startSearch profits from the warmed table */
+	bool ponderHit(int i, int j, int moveTime);
+	/* wait for the search to finish and return its move, false if no search was started */
+	bool waitSearch(int* i, int* j);
+	/* return the coordinates of the best move computed by the minimax algorithm, thinking MOVETIME ms */
+	void getBestMove(int player, int* i, int* j);
+	/* decide the field with player to move by the proof-number search: whether player can force a win,
+	   then whether his opponent can, see ProofInfo for how exact the answer is; each of the two searches stops after nodes (0 for no limit) or moveTime ms
+	   (0 for none), the table is that of setSolver; not to be called while searching */
+	void solve(int player, unsigned long long nodes, int moveTime, ProofInfo* info);
+	/* check a victory for player */
+	bool isVictory(int player, int* vi, int* vj, int* direction);
+	/* check a victory for player passing through his last move [i,j] */
+	bool isVictory(int player, int i, int j, int* vi, int* vj, int* direction);
+	/* check a draw */
+	bool isDraw();
+	void initTransTable();      // forget everything learnt in the previous games
+};
+
+/***********************************************************************************************/
+
+/* the engines compiled into the library, Field and Brain play on the NUMCOLS by NUMROWS board */
+typedef BasicField<NUMCOLS, NUMROWS> Field;
+typedef BasicBrain<NUMCOLS, NUMROWS> Brain;
+typedef BasicBatchEvaluator<NUMCOLS, NUMROWS> BatchEvaluator;
+typedef BasicField<15, 15> Field15;     // the tournament board
+typedef BasicBrain<15, 15> Brain15;
+typedef BasicBatchEvaluator<15, 15> BatchEvaluator15;
+typedef BasicField<19, 19> Field19;     // the go board
+typedef BasicBrain<19, 19> Brain19;
+typedef BasicBatchEvaluator<19, 19> BatchEvaluator19;
+
+#endif
@@ -0,0 +1,225 @@
+/* client: plays many games at once against the server on a Unix socket, the engine taking both sides,
+   and reports how long every move took beyond the time it was given */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define NUMCOLS 20                  // the board of the server
+#define NUMROWS 20
+
+/***********************************************************************************************/
+
+struct Game {
+	int id;                         // of the session on the server
+	int moves;
+	long long sent;                 // us when the last go was sent
+	bool over;
+};
+
+/***********************************************************************************************/
+
+class Client {
+	int fd;
+	std::string input;              // received but not yet complete line
+	int games;
+	int moveTime;
+	int maxMoves;                   // moves of every game, 0 to play them to the end
+	int randomMoves;                // stones of a random opening
+	unsigned long long seed;
+	const char* socketName;
+	std::vector<long long> delays;  // us every move took beyond moveTime
+	static long long now();
+	unsigned long long random();
+	void send(const char* format, ...);
+	bool readLine(std::string* line);
+	void go(Game* game);
+public:
+	Client();
+	~Client();
+	bool parse(int argc, char** argv);
+	bool connectServer();
+	bool run();
+};
+
+/***********************************************************************************************/
+
+Client::Client() {
+	fd = -1;
+	games = 100;
+	moveTime = 100;
+	maxMoves = 0;
+	randomMoves = 2;
+	seed = (unsigned long long) time(NULL);
+	socketName = NULL;
+}
+
+Client::~Client() {
+	if (fd >= 0) close(fd);
+}
+
+bool Client::parse(int argc, char** argv) {
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-socket")) socketName = value;
+		else if (!strcmp(arg, "-games")) games = atoi(value);
+		else if (!strcmp(arg, "-time")) moveTime = atoi(value);
+		else if (!strcmp(arg, "-moves")) maxMoves = atoi(value);
+		else if (!strcmp(arg, "-random")) randomMoves = atoi(value);
+		else if (!strcmp(arg, "-seed")) seed = strtoull(value, NULL, 10);
+		else return false;
+	}
+	return socketName && games >= 1 && moveTime >= 1 && randomMoves >= 0;
+}
+
+long long Client::now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* splitmix64, so that the client needs nothing of the engine */
+unsigned long long Client::random() {
+	unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+void Client::send(const char* format, ...) {
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	for (int sent = 0; sent < length; ) {
+		int n = (int) write(fd, text + sent, length - sent);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return;
+		sent += n;
+	}
+}
+
+bool Client::readLine(std::string* line) {
+	size_t end;
+	while ((end = input.find('\n')) == std::string::npos) {
+		char buffer[4096];
+		int n = (int) read(fd, buffer, sizeof(buffer));
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		input.append(buffer, n);
+	}
+	*line = input.substr(0, end);
+	input.erase(0, end + 1);
+	return true;
+}
+
+void Client::go(Game* game) {
+	game->sent = now();
+	send("go %d %d\n", game->id, moveTime);
+}
+
+bool Client::connectServer() {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketName) >= sizeof(address.sun_path)) return false;
+	strcpy(address.sun_path, socketName);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0) return true;
+	printf("cannot connect to %s\n", socketName);
+	return false;
+}
+
+bool Client::run() {
+	std::vector<Game> table(games);
+	std::string line;
+	// open all games, lay out their openings and let the engine move in every one of them
+	for (int g = 0; g < games; g++) {
+		send("new\n");
+		if (!readLine(&line) || sscanf(line.c_str(), "ok %d", &table[g].id) != 1) {
+			printf("server: %s\n", line.c_str());
+			return false;
+		}
+		table[g].moves = 0;
+		table[g].over = false;
+		bool taken[NUMCOLS][NUMROWS] = {{false}};
+		while (table[g].moves < randomMoves) {
+			int i = NUMCOLS/2 - 3 + (int) (random() % 7);
+			int j = NUMROWS/2 - 3 + (int) (random() % 7);
+			if (taken[i][j]) continue;
+			taken[i][j] = true;
+			send("play %d %d %d\n", table[g].id, i, j);
+			if (!readLine(&line) || line.compare(0, 2, "ok")) {
+				printf("server: %s\n", line.c_str());
+				return false;
+			}
+			table[g].moves++;
+		}
+	}
+	long long start = now();
+	for (int g = 0; g < games; g++)
+		go(&table[g]);
+	int running = games;
+	int moves = 0;
+	while (running > 0 && readLine(&line)) {
+		int id, i, j;
+		char result[16] = "";
+		if (sscanf(line.c_str(), "move %d %d %d %15s", &id, &i, &j, result) < 3) {
+			if (line.compare(0, 2, "ok")) printf("server: %s\n", line.c_str());
+			continue;
+		}
+		Game* game = NULL;
+		for (int g = 0; g < games && !game; g++)
+			if (table[g].id == id) game = &table[g];
+		if (!game) continue;
+		delays.push_back(now() - game->sent - moveTime * 1000LL);
+		moves++;
+		game->moves++;
+		if (*result || (maxMoves && game->moves >= maxMoves)) {
+			game->over = true;
+			running--;
+			send("free %d\n", id);
+		} else
+			go(game);
+	}
+	long long time = now() - start;
+	send("stats\n");
+	while (readLine(&line) && line.compare(0, 5, "stats"));
+	printf("%s\n", line.c_str());
+	if (running > 0) {
+		printf("the server closed the connection with %d games running\n", running);
+		return false;
+	}
+	std::sort(delays.begin(), delays.end());
+	int n = (int) delays.size();
+	printf("%d games, %d moves in %.1f s, %.1f moves/s\n", games, moves, time / 1e6, moves * 1e6 / time);
+	printf("ms beyond the %d ms of a move: median %.1f, 90%% %.1f, 99%% %.1f, max %.1f\n", moveTime,
+		delays[n / 2] / 1000.0, delays[n * 9 / 10] / 1000.0, delays[n * 99 / 100] / 1000.0, delays[n - 1] / 1000.0);
+	return true;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Client* client = new Client();
+	if (!client->parse(argc, argv)) {
+		printf("usage: client -socket path [-games n] [-time ms] [-moves n] [-random stones] [-seed n]\n");
+		delete client;
+		return 1;
+	}
+	int status = 0;
+	if (!client->connectServer() || !client->run()) status = 1;
+	delete client;
+	return status;
+}
@@ -0,0 +1,234 @@
+/* evaltest: checks the compiled block table against the interpreter of the block strings it replaced, on
+   random boards scored from scratch with random block values, by the search and by BatchEvaluator, and along
+   random sequences of moves and take-backs scored incrementally; any difference is reported and the exit
+   code is 1 */
+
+#include <stdio.h>
+#include <string.h>
+#include "brain.h"
+
+#define TESTSEED 12345
+#define TESTBATCH 13                // boards evaluated together, not a whole number of lanes
+
+/***********************************************************************************************/
+
+class EvalTest {
+	int boards;                     // scored from scratch, per board size
+	int sequences;                  // of moves and take-backs, per board size
+	int moves;                      // steps of every sequence
+	unsigned long long state;       // of the random numbers
+	int random(int n);              // 0..n-1
+	template<int numCols, int numRows> void randomBoard(BasicField<numCols, numRows>* field);
+	template<int numCols, int numRows>
+	int interpretBlocks(const Evaluation* evaluation, const BasicField<numCols, numRows>* field, int player);
+	/* compare the scores of the engine with the interpreter */
+	template<int numCols, int numRows>
+	int check(BasicBrain<numCols, numRows>* brain, BasicSearcher<numCols, numRows>* searcher, const char* what, int n,
+		int step);
+	template<int numCols, int numRows> int testBoards();
+	template<int numCols, int numRows> int testBatch();
+	template<int numCols, int numRows> int testSequences();
+public:
+	EvalTest();
+	bool parse(int argc, char** argv);
+	int run();                      // the number of differences
+};
+
+/***********************************************************************************************/
+
+EvalTest::EvalTest() {
+	boards = 1000;
+	sequences = 20;
+	moves = 200;
+	state = TESTSEED;
+}
+
+bool EvalTest::parse(int argc, char** argv) {
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-boards")) boards = atoi(value);
+		else if (!strcmp(arg, "-sequences")) sequences = atoi(value);
+		else if (!strcmp(arg, "-moves")) moves = atoi(value);
+		else if (!strcmp(arg, "-seed")) state = strtoull(value, NULL, 10);
+		else return false;
+	}
+	return true;
+}
+
+int EvalTest::random(int n) {       // splitmix64
+	unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return (int) ((z ^ (z >> 31)) % n);
+}
+
+/* the pay-off of the blocks for player, matched one character at a time as the engine once did: ' ' an empty
+   cell, 'p' a stone of player, 'o' one of the opponent, '$' the end of the block, which must be on the field */
+template<int numCols, int numRows>
+int EvalTest::interpretBlocks(const Evaluation* evaluation, const BasicField<numCols, numRows>* field, int player) {
+	static const int dirI[4] = {1, 0, 1, -1};
+	static const int dirJ[4] = {0, 1, 1, 1};
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int result = 0;
+	for (int k = 0; k < NUMBLOCKS; k++)
+		for (int i = 0; i < numCols; i++)
+			for (int j = 0; j < numRows; j++)
+				for (int d = 0; d < 4; d++)
+					for (int l = 0; l < 10; l++) {
+						int ii = i + l*dirI[d];
+						int jj = j + l*dirJ[d];
+						if (ii < 0 || ii >= numCols || jj >= numRows) break;
+						char c = evaluation->blocks[k].string[l];
+						int item = field->at(ii, jj);
+						if ((c == ' ' && item == 0) || (c == 'p' && item == player) || (c == 'o' && item == opponent))
+							continue;
+						if (c == '$') result += evaluation->blocks[k].value;
+						break;
+					}
+	return result;
+}
+
+/* from empty to nearly full, so that every block meets stones, other stones and the edges */
+template<int numCols, int numRows>
+void EvalTest::randomBoard(BasicField<numCols, numRows>* field) {
+	int density = random(100);
+	for (int i = 0; i < numCols; i++)
+		for (int j = 0; j < numRows; j++)
+			field->set(i, j, random(100) < density ? CIRCLE + random(2) : 0);
+}
+
+template<int numCols, int numRows>
+int EvalTest::check(BasicBrain<numCols, numRows>* brain, BasicSearcher<numCols, numRows>* searcher, const char* what,
+	int n, int step) {
+	int wrong = 0;
+	for (int p = CIRCLE; p <= CROSS; p++) {
+		int expected = interpretBlocks(&brain->evaluation, &searcher->field, p);
+		if (searcher->totalScore[p] == expected) continue;
+		printf("%dx%d %s %d, step %d, player %d: compiled %d, interpreted %d\n", numCols, numRows, what, n, step, p,
+			searcher->totalScore[p], expected);
+		wrong++;
+	}
+	return wrong;
+}
+
+/* the values of the blocks are drawn anew for every board but the first and compiled again */
+template<int numCols, int numRows>
+int EvalTest::testBoards() {
+	BasicField<numCols, numRows>* field = new BasicField<numCols, numRows>();
+	BasicBrain<numCols, numRows>* brain = new BasicBrain<numCols, numRows>(field);
+	BasicSearcher<numCols, numRows>* searcher = new BasicSearcher<numCols, numRows>(brain, 0);
+	int wrong = 0;
+	for (int b = 0; b < boards; b++) {
+		if (b) {
+			for (int k = 0; k < NUMBLOCKS; k++)
+				brain->evaluation.blocks[k].value = random(20001) - 10000;
+			brain->evaluation.compile();
+		}
+		randomBoard(&searcher->field);
+		searcher->initLineScores();
+		wrong += check(brain, searcher, "board", b, 0);
+	}
+	delete searcher;
+	delete brain;
+	delete field;
+	return wrong;
+}
+
+/* the values of the blocks are drawn anew for every batch but the first and compiled again, BatchEvaluator
+   scores the packed boards from scratch */
+template<int numCols, int numRows>
+int EvalTest::testBatch() {
+	typedef BasicField<numCols, numRows> Field;
+	BasicBatchEvaluator<numCols, numRows>* batch = new BasicBatchEvaluator<numCols, numRows>();
+	Field* fields = new Field[TESTBATCH];
+	unsigned char positions[TESTBATCH * Field::packedSize];
+	unsigned char players[TESTBATCH];
+	int values[TESTBATCH];
+	int wrong = 0;
+	for (int b = 0; b < boards; b += TESTBATCH) {
+		if (b) {
+			for (int k = 0; k < NUMBLOCKS; k++)
+				batch->evaluation.blocks[k].value = random(20001) - 10000;
+			batch->evaluation.compile();
+		}
+		for (int n = 0; n < TESTBATCH; n++) {
+			randomBoard(&fields[n]);
+			fields[n].pack(positions + n * Field::packedSize);
+			players[n] = (unsigned char) (CIRCLE + random(2));
+		}
+		batch->evaluate(positions, TESTBATCH, players, values);
+		for (int n = 0; n < TESTBATCH; n++) {
+			int expected = interpretBlocks(&batch->evaluation, &fields[n], players[n]);
+			if (values[n] == expected) continue;
+			printf("%dx%d batch board %d, player %d: compiled %d, interpreted %d\n", numCols, numRows, b + n,
+				players[n], values[n], expected);
+			wrong++;
+		}
+	}
+	delete[] fields;
+	delete batch;
+	return wrong;
+}
+
+/* every sequence starts from a random board; a move goes on a random empty cell, a take-back removes the
+   last stone still played, and after each step the incremental scores are checked */
+template<int numCols, int numRows>
+int EvalTest::testSequences() {
+	BasicField<numCols, numRows>* field = new BasicField<numCols, numRows>();
+	BasicBrain<numCols, numRows>* brain = new BasicBrain<numCols, numRows>(field);
+	BasicSearcher<numCols, numRows>* searcher = new BasicSearcher<numCols, numRows>(brain, 0);
+	Cell played[numCols*numRows];
+	int wrong = 0;
+	for (int s = 0; s < sequences && !wrong; s++) {
+		randomBoard(&searcher->field);
+		searcher->initLineScores();
+		int numPlayed = 0;
+		for (int m = 0; m < moves && !wrong; m++) {
+			int player = (m & 1) ? CIRCLE : CROSS;
+			if (numPlayed && (random(3) == 0 || searcher->field.stones == numCols*numRows)) {
+				numPlayed--;
+				searcher->unmakeMove(played[numPlayed].i, played[numPlayed].j,
+					searcher->field.at(played[numPlayed].i, played[numPlayed].j));
+			} else if (searcher->field.stones < numCols*numRows) {
+				int i, j;
+				do {
+					i = random(numCols);
+					j = random(numRows);
+				} while (searcher->field.at(i, j));
+				searcher->makeMove(i, j, player);
+				played[numPlayed].i = i;
+				played[numPlayed++].j = j;
+			}
+			wrong += check(brain, searcher, "sequence", s, m);
+		}
+	}
+	delete searcher;
+	delete brain;
+	delete field;
+	return wrong;
+}
+
+int EvalTest::run() {
+	int wrong = 0;                  // with the values of the game, then with random ones
+	wrong += testSequences<NUMCOLS, NUMROWS>() + testBoards<NUMCOLS, NUMROWS>() + testBatch<NUMCOLS, NUMROWS>();
+	wrong += testSequences<15, 15>() + testBoards<15, 15>() + testBatch<15, 15>();
+	wrong += testSequences<19, 19>() + testBoards<19, 19>() + testBatch<19, 19>();
+	return wrong;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	EvalTest* test = new EvalTest();
+	if (!test->parse(argc, argv)) {
+		printf("usage: evaltest [-boards n] [-sequences n] [-moves n] [-seed n]\n");
+		delete test;
+		return 1;
+	}
+	int wrong = test->run();
+	printf("%s, %d differences\n", wrong ? "FAILED" : "passed", wrong);
+	delete test;
+	return wrong ? 1 : 0;
+}
@@ -3,30 +3,18 @@
 #include <windows.h>
 #include <windowsx.h>
 #include <math.h>
-#include <assert.h>
 #include <stdlib.h>
-#include <time.h>
-#include <limits.h>
+#include "brain.h"
+#include "render.h"
 
 #define IDB_NEW_GAME 1001
 #define IDB_DEMO 1002
 #define IDB_ABOUT 1003
 #define WNDCLASSNAME "WIN32GOMOKU"
 #define WNDTITLE "GoMoku"
-#define MOVETIME 2500
-#define MAXDEPTH 20
-#define SQUARE 20                   // size of the square
-#define NUMROWS 20
-#define NUMCOLS 20
-#define NUMBLOCKS 26
-#define TRANSSIZE 1600451           // transposition table size
 #define SIZEX (NUMCOLS*SQUARE+1)    // x and y sizes of the window in pixels
 #define SIZEY (NUMROWS*SQUARE+1)
-#define LINECOL	RGB(100, 100, 100)  // line color for the desk
-#define BGCOL RGB(219, 178, 113)    // background color of the desk
-#define SPRITESIZE 17               // x or y size of sprite
-#define CIRCLE 1                    // token for a circle
-#define CROSS 2                     // token for a cross
+#define RECORDFILE "gomoku.games"   // the played games, see RecordReader
 
 /***********************************************************************************************/
 
@@ -43,59 +31,6 @@ void ClientResize(HWND hwnd, int nWidth, int nHeight) {
 /***********************************************************************************************/
 /***********************************************************************************************/
 
-class Application;                  // forward declaration
-
-class Field {                       // the playing field consisting of crosses and circles
-	struct {
-		int item;
-		bool pernament;
-	} data[NUMCOLS+2][NUMROWS+2];
-public:
-	Field();
-	int& at(int i, int j);          // returns item on index i,j
-	bool& isPernament(int i, int j);
-};
-
-/***********************************************************************************************/
-
-class Brain {
-	struct Block {
-		char string[10];
-		int value;
-	} blocks[NUMBLOCKS];
-	Field* field;
-	struct {
-		unsigned hash;
-		int value;
-	} transTable[TRANSSIZE];   // the transposition table
-	int bestI;
-	int bestJ;  // the best position computed by the algorithm
-	bool firstRun;
-	struct {
-		int i;
-		int j;
-	} bestCoords[MAXDEPTH+1];
-	clock_t start;
-	int bestPrice;
-	bool isAdmissible(int i, int j);  // check if the [i,j]-position is admissible
-	int payOff(int player);  // compute the pay-off for player
-public:
-	unsigned zobristCodes[NUMCOLS][NUMROWS][3];
-	unsigned zobristKey;
-	Brain(Field* field);
-	/* the minimax algorithm with alpha-beta prunning */
-	int minmax(int player, int depth, int maxDepth, int alpha, int beta);
-	/* return the coordinates of the best move computed by the minimax algorithm */
-	void getBestMove(int player, int* i, int* j);
-	/* check a victory for player */
-	bool isVictory(int player, int* vi, int* vj, int* direction);
-	/* check a draw */
-	bool isDraw();
-	void initTransTable();
-};
-
-/***********************************************************************************************/
-
 class Application {
 	int gameCount;
 	HWND hwnd;                      // handle of the main window
@@ -103,23 +38,31 @@ class Application {
 	HWND btDemo;
 	HWND btAbout;
 	HDC hdc;                        // HDC of the main window
-	HBRUSH brush;                   // brush used for painting the square table
-	HPEN pen;                       // pen used for painting the square table
+	HDC memDC;                      // holds bitmap, the buffer view draws into
+	HBITMAP bitmap;
+	Renderer* view;                 // the desk, the stones and the score sprites
 	bool idle;                      // true when not computing the best move
 	int scoreCross;
 	int scoreCircle;
 	bool playingDemo;
-	RECT oldrect;
+	int hoverI;                     // the framed square under the mouse, -1 for none
+	int hoverJ;
 	Field* field;
 	Brain* brain;
-	void putSprite(int x, int y, char* sprite);	// draw a sprite
+	RecordWriter records;           // every game played is appended to RECORDFILE
+	bool recording;                 // RECORDFILE could be opened
+	GameRecord game;
 	void putCircle(int i, int j);
 	void putCross(int i, int j);
-	void renderDesk();              // plot the playing desk, circles and crosses
-	void clearDesk();
+	void recordMove(int i, int j, int player);
+	void present();                 // copy the parts of the buffer which changed to the window
+	void clearDesk(int result = 0); // the game is recorded with result, see GameRecord::finish
 	void showScore();
 	void showVictory(int vi, int vj, int direction);
 	void playDemo();
+	/* let the brain search while the window keeps handling its messages; [i,j] is the last move of the
+	   opponent on entry and the move found on return */
+	void think(int player, int* i, int* j);
 	static LRESULT CALLBACK staticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 	LRESULT wndProc(UINT msg, WPARAM wParam, LPARAM lParam);
 public:
@@ -131,386 +74,19 @@ public:
 /***********************************************************************************************/
 /***********************************************************************************************/
 
-char circle[] = {
-	00, 00, 00, 00, 00, 00, 06, 06, 06, 06, 06, 00, 00, 00, 00, 00, 00,
-	00, 00, 00, 00, 06, 05, 05, 05, 05, 05, 05, 05, 06, 00, 00, 00, 00,
-	00, 00, 00, 06, 05, 04, 04, 04, 04, 04, 04, 04, 05, 06, 00, 00, 00,
-	00, 00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00, 00,
-	00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00,
-	00, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 00,
-	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
-	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
-	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
-	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
-	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
-	00, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 00,
-	00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00,
-	00, 00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00, 00,
-	00, 00, 00, 06, 05, 04, 04, 04, 04, 04, 04, 04, 05, 06, 00, 00, 00,
-	00, 00, 00, 00, 06, 05, 05, 05, 05, 05, 05, 05, 06, 00, 00, 00, 00,
-	00, 00, 00, 00, 00, 00, 06, 06, 06, 06, 06, 00, 00, 00, 00, 00, 00,
-
-};
-
-char cross[] = {
-	00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00,
-	00, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 00,
-	00, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 00,
-	00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00,
-	00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00,
-	00, 00, 00, 03, 02, 01, 02, 03, 00, 03, 02, 01, 02, 03, 00, 00, 00,
-	00, 00, 00, 00, 03, 02, 01, 02, 03, 02, 01, 02, 03, 00, 00, 00, 00,
-	00, 00, 00, 00, 00, 03, 02, 01, 02, 01, 02, 03, 00, 00, 00, 00, 00,
-	00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00,
-	00, 00, 00, 00, 00, 03, 02, 01, 02, 01, 02, 03, 00, 00, 00, 00, 00,
-	00, 00, 00, 00, 03, 02, 01, 02, 03, 02, 01, 02, 03, 00, 00, 00, 00,
-	00, 00, 00, 03, 02, 01, 02, 03, 00, 03, 02, 01, 02, 03, 00, 00, 00,
-	00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00,
-	00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00,
-	00, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 00,
-	00, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 00,
-	00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00
-};
-
-/***********************************************************************************************/
-/***********************************************************************************************/
-
-Field::Field() {
-	for (int i = 0; i < NUMCOLS + 2; i++)
-		for (int j = 0; j < NUMROWS + 2; j++) {
-			data[i][j].item = 0;
-		}
-}
-
-int& Field::at(int i, int j) {
-	return data[i+1][j+1].item;
-}
-
-bool& Field::isPernament(int i, int j) {
-	return data[i+1][j+1].pernament;
-}
-
-/***********************************************************************************************/
-
-Brain::Brain(Field* field) {
-	this->field = field;
-	strcpy(blocks[0].string, " pp $"); blocks[0].value = 200;
-	strcpy(blocks[1].string, " ppp $"); blocks[1].value = 5000;
-	strcpy(blocks[2].string, "pppp $"); blocks[2].value = 8000;
-	strcpy(blocks[3].string, "oppp $"); blocks[3].value = 100;
-	strcpy(blocks[4].string, " pppo$"); blocks[4].value = 100;
-	strcpy(blocks[5].string, " pp p $"); blocks[5].value = 5000;
-	strcpy(blocks[6].string, " p pp $"); blocks[6].value = 5000;
-	strcpy(blocks[7].string, "ppppp$"); blocks[7].value = 1000000;
-	strcpy(blocks[8].string, " pppp$"); blocks[8].value = 8000;
-	strcpy(blocks[9].string, "p ppp$"); blocks[9].value = 8000;
-	strcpy(blocks[10].string, "pp pp$"); blocks[10].value = 8000;
-	strcpy(blocks[11].string, "ppp p$"); blocks[11].value = 8000;
-	strcpy(blocks[12].string, " p p $"); blocks[12].value = 200;
-	strcpy(blocks[13].string, " oo $"); blocks[13].value = -300;
-	strcpy(blocks[14].string, " ooo $"); blocks[14].value = -7000;
-	strcpy(blocks[15].string, "oooo $"); blocks[15].value = -13000;
-	strcpy(blocks[16].string, "pooo $"); blocks[16].value = -200;
-	strcpy(blocks[17].string, " ooop$"); blocks[17].value = -200;
-	strcpy(blocks[18].string, " oo o $"); blocks[18].value = -7000;
-	strcpy(blocks[19].string, " o oo $"); blocks[19].value = -7000;
-	strcpy(blocks[20].string, "ooooo$"); blocks[20].value = -1200000;
-	strcpy(blocks[21].string, " oooo$"); blocks[21].value = -13000;
-	strcpy(blocks[22].string, "o ooo$"); blocks[22].value = -13000;
-	strcpy(blocks[23].string, "oo oo$"); blocks[23].value = -13000;
-	strcpy(blocks[24].string, "ooo o$"); blocks[24].value = -13000;
-	strcpy(blocks[25].string, " o o $"); blocks[25].value = -300;
-	srand((unsigned) time(NULL));
-	for (int i = 0; i < NUMCOLS; i++)
-		for (int j = 0; j < NUMROWS; j++) 
-			for (int k = 0; k < 3; k++)
-				zobristCodes[i][j][k] = rand() | (rand() << 15);
-}
-
-void Brain::initTransTable() {
-	for (int i = 0; i < TRANSSIZE; i++) {
-		transTable[i].hash = 0xffffffff;
-	}
-	zobristKey = 0;
-	for (int i = 0; i < NUMCOLS; i++) {
-		for (int j = 0; j < NUMROWS; j++) {
-			zobristKey ^= zobristCodes[i][j][0];
-		}
-	}
-}
-
-bool Brain::isAdmissible(int i, int j) {
-	return (field->at(i, j) == 0 &&
-		(  field->at(i-1,j-1) != 0 || field->at(i, j-1) != 0 || field->at(i+1,j-1) != 0
-		|| field->at(i-1,j) != 0 || field->at(i+1,j) != 0
-		|| field->at(i-1,j+1) != 0 || field->at(i, j+1) != 0 || field->at(i+1,j+1) != 0
-		));
-}
-
-bool Brain::isVictory(int player, int* vi, int* vj, int* direction) {
-	int k;
-	for (int i = 0; i < NUMCOLS; i++) {
-		for (int j = 0; j < NUMROWS; j++) {
-			for (k = 0; k < 5 && i + k < NUMCOLS && field->at(i + k, j) == player; k++);
-			if (k == 5) {
-				if (vi) *vi = i;
-				if (vj) *vj = j;
-				if (direction) *direction = 1;
-				return true;
-			}
-			for (k = 0; k < 5 && j + k < NUMROWS && field->at(i, j + k) == player; k++);
-			if (k == 5) {
-				if (vi) *vi = i;
-				if (vj) *vj = j;
-				if (direction) *direction = 2;
-				return true;
-			}
-			for (k = 0; k < 5 && i + k < NUMCOLS && j + k < NUMROWS && field->at(i + k, j + k) == player; k++);
-			if (k == 5) {
-				if (vi) *vi = i;
-				if (vj) *vj = j;
-				if (direction) *direction = 3;
-				return true;
-			}
-			for (k = 0; k < 5 && i - k > 0 && j + k < NUMROWS && field->at(i - k, j + k) == player; k++);
-			if (k == 5) {
-				if (vi) *vi = i;
-				if (vj) *vj = j;
-				if (direction) *direction = 4;
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
-bool Brain::isDraw() {
-	for (int i = 0; i < NUMCOLS; i++) {
-		for (int j = 0; j < NUMROWS; j++) {
-			if (isAdmissible(i, j)) return false;
-		}
-	}
-	Sleep(1000);
-	return true;
-}
-
-int Brain::payOff(int player) {
-	int result = 0;
-	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
-	for (int k = 0; k < NUMBLOCKS; k++) {
-		for (int i = 0; i < NUMCOLS; i++) {
-			for (int j = 0; j < NUMROWS; j++) {
-				for (int l = 0; l < 10; l++) {
-					if (i + l >= NUMCOLS) break;
-					if (blocks[k].string[l] == ' ' && field->at(i + l, j) == 0);
-					else if (blocks[k].string[l] == 'p' && field->at(i + l, j) == player);
-					else if (blocks[k].string[l] == 'o' && field->at(i + l, j) == opponent);
-					else if (blocks[k].string[l] == '$') {
-						result += blocks[k].value;
-						break;
-					}
-					else break;
-				}
-				for (int l = 0; l < 10; l++) {
-					if (j + l >= NUMROWS) break;
-					if (blocks[k].string[l] == ' ' && field->at(i, j + l) == 0);
-					else if (blocks[k].string[l] == 'p' && field->at(i, j + l) == player);
-					else if (blocks[k].string[l] == 'o' && field->at(i, j + l) == opponent);
-					else if (blocks[k].string[l] == '$') {
-						result += blocks[k].value;
-						break;
-					}
-					else break;
-				}
-				for (int l = 0; l < 10; l++) {
-					if (i - l < 0) break;
-					if (j + l >= NUMROWS) break;
-					if (blocks[k].string[l] == ' ' && field->at(i - l, j + l) == 0);
-					else if (blocks[k].string[l] == 'p' && field->at(i - l, j + l) == player);
-					else if (blocks[k].string[l] == 'o' && field->at(i - l, j + l) == opponent);
-					else if (blocks[k].string[l] == '$') {
-						result += blocks[k].value;
-						break;
-					}
-					else break;
-				}
-				for (int l = 0; l < 10; l++) {
-					if (i + l >= NUMCOLS) break;
-					if (j + l >= NUMROWS) break;
-					if (blocks[k].string[l] == ' ' && field->at(i + l, j + l) == 0);
-					else if (blocks[k].string[l] == 'p' && field->at(i + l, j + l) == player);
-					else if (blocks[k].string[l] == 'o' && field->at(i + l, j + l) == opponent);
-					else if (blocks[k].string[l] == '$') {
-						result += blocks[k].value;
-						break;
-					}
-					else break;
-				}
-			}
-		}
-	}
-	return result + (rand() % 30);
-}
-
-int Brain::minmax(int player, int depth, int maxDepth, int alpha, int beta) {
-	static unsigned msgCnt = 0;
-	if (msgCnt++ % 400 == 0) {
-		MSG msg;
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-			if (msg.message == WM_QUIT)
-				exit(0);
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
-	}
-	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
-	if (depth == maxDepth) {
-		if (transTable[zobristKey % TRANSSIZE].hash == zobristKey)
-			return transTable[zobristKey % TRANSSIZE].value;
-		int result = payOff(depth % 2 == 0 ? player : opponent);
-		transTable[zobristKey % TRANSSIZE].hash = zobristKey;
-		transTable[zobristKey % TRANSSIZE].value = result;
-		return result;
-	}
-	if (clock() - start > MOVETIME) {
-		return INT_MIN;
-	}
-	int price;
-	int optI;
-	int optJ;
-	if (firstRun && depth == maxDepth - 1)
-		firstRun = false;
-	if (firstRun && maxDepth > 1 && isAdmissible(bestCoords[depth].i, bestCoords[depth].j)) {
-		int ii = bestCoords[depth].i;
-		int jj = bestCoords[depth].j;
-		field->at(ii, jj) = player;
-		field->isPernament(ii, jj) = false;
-		zobristKey ^= zobristCodes[ii][jj][0];
-		zobristKey ^= zobristCodes[ii][jj][player];
-		if (depth % 2 == 0) {
-			price = minmax(opponent, depth + 1, maxDepth, alpha, beta);
-			if (price > alpha) {
-				alpha = price;
-				optI = ii;
-				optJ = jj;
-			}
-			if (alpha >= beta) {
-				field->at(ii, jj) = 0;
-				zobristKey ^= zobristCodes[ii][jj][player];
-				zobristKey ^= zobristCodes[ii][jj][0];
-				if (depth == 0 && price > bestPrice) {
-					bestPrice = price;
-					bestI = optI;
-					bestJ = optJ;
-				}
-				return alpha;
-			}
-		} else {
-			price = minmax(opponent, depth + 1, maxDepth, alpha, beta);
-			if (price < beta) {
-				beta = price;
-				optI = ii;
-				optJ = jj;
-			}
-			if (alpha >= beta) {
-				field->at(ii, jj) = 0;
-				zobristKey ^= zobristCodes[ii][jj][player];
-				zobristKey ^= zobristCodes[ii][jj][0];
-				return beta;
-			}
-		}
-		field->at(ii, jj) = 0;
-		zobristKey ^= zobristCodes[ii][jj][player];
-		zobristKey ^= zobristCodes[ii][jj][0];
-		if (depth == 0 && price > bestPrice) {
-			bestPrice = price;
-			bestI = optI;
-			bestJ = optJ;
-		}
-	}
-	for (int ii = 0; ii < NUMCOLS; ii++) {
-		for (int jj = 0; jj < NUMROWS; jj++) {
-			if (!isAdmissible(ii, jj)) continue;
-			if (maxDepth > 1 && ii == bestCoords[depth].i && jj == bestCoords[depth].j) continue;
-			field->at(ii, jj) = player;
-			field->isPernament(ii, jj) = false;
-			zobristKey ^= zobristCodes[ii][jj][0];
-			zobristKey ^= zobristCodes[ii][jj][player];
-			if (depth % 2 == 0) {
-				price = minmax(opponent, depth + 1, maxDepth, alpha, beta);
-				if (price > alpha) {
-					alpha = price;
-					optI = ii;
-					optJ = jj;
-					bestCoords[depth].i = ii;
-					bestCoords[depth].j = jj;
-				}
-				if (alpha >= beta) {
-					field->at(ii, jj) = 0;
-					zobristKey ^= zobristCodes[ii][jj][player];
-					zobristKey ^= zobristCodes[ii][jj][0];
-					if (depth == 0 && price > bestPrice) {
-						bestPrice = price;
-						bestI = optI;
-						bestJ = optJ;
-					}
-					return alpha;
-				}
-			} else {
-				price = minmax(opponent, depth + 1, maxDepth, alpha, beta);
-				if (price < beta) {
-					beta = price;
-					optI = ii;
-					optJ = jj;
-					bestCoords[depth].i = ii;
-					bestCoords[depth].j = jj;
-				}
-				if (alpha >= beta) {
-					field->at(ii, jj) = 0;
-					zobristKey ^= zobristCodes[ii][jj][player];
-					zobristKey ^= zobristCodes[ii][jj][0];
-					return beta;
-				}
-			}
-			field->at(ii, jj) = 0;
-			zobristKey ^= zobristCodes[ii][jj][player];
-			zobristKey ^= zobristCodes[ii][jj][0];
-			if (depth == 0 && price > bestPrice) {
-				bestPrice = price;
-				bestI = optI;
-				bestJ = optJ;
-			}
-		}
-	}
-	return (depth % 2 == 0) ? alpha : beta;
-}
-
-void Brain::getBestMove(int player, int* i, int* j) {
-	start = clock();
-	initTransTable();
-	bestPrice = INT_MIN;
-	int d;
-	for (d = 1; clock() - start < MOVETIME && d <= MAXDEPTH; d++) {
-		firstRun = true;
-		minmax(player, 0, d, INT_MIN, INT_MAX);
-	}
-	*i = bestI;
-	*j = bestJ;
-}
-
-/***********************************************************************************************/
-
 Application::Application(HINSTANCE hInstance, int nCmdShow) {
 	scoreCross = 0;
 	scoreCircle = 0;
 	gameCount = 0;
 	playingDemo = false;
-	oldrect.left = 0;
-	oldrect.top = 0;
-	oldrect.right = SQUARE + 1;
-	oldrect.left = SQUARE + 1;
+	hoverI = hoverJ = -1;
+	hdc = NULL;                     // nothing is presented before the window is shown
+	srand((unsigned) time(NULL));   // the random first stones, the brain has its own generator
 	field = new Field();
 	brain = new Brain(field);
+	brain->setBook("gomoku.book");  // play without a book if there is none
+	brain->setWeights("gomoku.weights");  // the built-in values of the blocks if there are none
+	recording = records.open(RECORDFILE);  // the games are not kept if it cannot be written
 	WNDCLASSEX wc;
 	wc.cbSize = sizeof(WNDCLASSEX);
 	wc.style = CS_VREDRAW | CS_HREDRAW | CS_OWNDC;
@@ -526,6 +102,19 @@ Application::Application(HINSTANCE hInstance, int nCmdShow) {
 	wc.lpszClassName = wndClassName;
 	wc.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
 	RegisterClassEx(&wc); // todo: exception if result == null
+	BITMAPINFO info;                // top-down 32-bit, the layout of Renderer::pixels
+	memset(&info, 0, sizeof(info));
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = SIZEX;
+	info.bmiHeader.biHeight = -(SIZEY + 50);
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+	void* bits;
+	bitmap = CreateDIBSection(NULL, &info, DIB_RGB_COLORS, &bits, NULL, 0);
+	memDC = CreateCompatibleDC(NULL);
+	SelectObject(memDC, bitmap);
+	view = new Renderer(NUMCOLS, NUMROWS, SIZEX, SIZEY + 50, (unsigned*) bits);
 	hwnd = CreateWindowEx(
 		0,
 		WNDCLASSNAME,
@@ -538,9 +127,6 @@ Application::Application(HINSTANCE hInstance, int nCmdShow) {
 	UpdateWindow(hwnd);
 	ShowWindow(hwnd, nCmdShow);
 	hdc = GetDC(hwnd);
-	brush = CreateSolidBrush(BGCOL);
-	pen = CreatePen(PS_SOLID, 1, LINECOL);
-	renderDesk();
 	showScore();
 	idle = true;
 }
@@ -596,66 +182,61 @@ LRESULT Application::wndProc(UINT msg, WPARAM wParam, LPARAM lParam) {
 			int i = (int) floor((float) GET_X_LPARAM(lParam)/SQUARE);  
 			int j = (int) floor((float) GET_Y_LPARAM(lParam)/SQUARE);
 			if (i >= NUMCOLS || j >= NUMROWS) return 0;
-			int x = (int) floor((float) GET_X_LPARAM(lParam)/SQUARE)*SQUARE;  
-			int y = (int) floor((float) GET_Y_LPARAM(lParam)/SQUARE)*SQUARE;
-			RECT rect = {x, y, x + SQUARE + 1, y + SQUARE + 1};
-			HBRUSH tmpbrush = CreateSolidBrush(LINECOL);
-			FrameRect(hdc, &oldrect, tmpbrush);
-			if (x < NUMCOLS*SQUARE && y < NUMROWS*SQUARE) FrameRect(hdc, &rect, (HBRUSH) GetStockObject(WHITE_BRUSH));
-			oldrect = rect;
-			DeleteObject(tmpbrush);
+			if (i == hoverI && j == hoverJ) return 0;
+			if (hoverI >= 0) view->frameSquare(hoverI, hoverJ, LINECOL);
+			view->frameSquare(i, j, FRAMECOL);
+			hoverI = i;
+			hoverJ = j;
+			present();
 			return 0; }
 		case WM_LBUTTONDOWN: {
 			if (!idle) return 0;
 			int i = (int) floor((float) GET_X_LPARAM(lParam)/SQUARE);  
 			int j = (int) floor((float) GET_Y_LPARAM(lParam)/SQUARE);
-			if (i == NUMCOLS || j == NUMROWS) return 0;
+			if (i >= NUMCOLS || j >= NUMROWS) return 0;
 			if (field->at(i, j) != 0) return 0;
 			putCircle(i, j);
 			idle = false;
 			int vi, vj, direction;
 			if (brain->isDraw()) {
-				clearDesk();
+				Sleep(1000);
+				clearDesk(RECORDDRAW);
 				if (++gameCount % 2 == 1)
 					putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 			}
-			if (brain->isVictory(CIRCLE, &vi, &vj, &direction)) {
+			if (brain->isVictory(CIRCLE, i, j, &vi, &vj, &direction)) {
 				showVictory(vi, vj, direction);
 				scoreCircle++;
-				clearDesk();
+				clearDesk(CIRCLE);
 				showScore();
 				if (++gameCount % 2 == 1)
 					putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 			} else {
-				brain->getBestMove(CROSS, &i, &j);
+				think(CROSS, &i, &j);
 				putCross(i, j);
 			}
 			if (brain->isDraw()) {
-				clearDesk();
+				Sleep(1000);
+				clearDesk(RECORDDRAW);
 				if (++gameCount % 2 == 1)
 					putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 			}
-			if (brain->isVictory(CROSS, &vi, &vj, &direction)) {
+			if (brain->isVictory(CROSS, i, j, &vi, &vj, &direction)) {
 				showVictory(vi, vj, direction);
 				scoreCross++;
-				clearDesk();
+				clearDesk(CROSS);
 				showScore();
 				if (++gameCount % 2 == 1)
 					putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 			}
+			brain->ponder(CROSS);       // think about the expected reply while the user does
 			idle = true;
 			return 0; }
-		case WM_PAINT: {
+		case WM_PAINT: {              // the buffer holds the whole picture, nothing is drawn again
 			BeginPaint(hwnd, &ps);
-			EndPaint(hwnd, &ps);			
-			return 0; }
-		case WM_ACTIVATE: {
-			renderDesk();
-			showScore();
-			return 0; }
-		case WM_MOVE: {
-			renderDesk();
-			showScore();
+			BitBlt(ps.hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left,
+				ps.rcPaint.bottom - ps.rcPaint.top, memDC, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+			EndPaint(hwnd, &ps);
 			return 0; }
 		case WM_CLOSE: 
 		case WM_DESTROY: { PostQuitMessage(0); return 0; }
@@ -664,82 +245,84 @@ LRESULT Application::wndProc(UINT msg, WPARAM wParam, LPARAM lParam) {
 	return DefWindowProc(hwnd, msg, wParam, lParam);}
 
 void Application::putCircle(int i, int j) {
-	putSprite(i*(SQUARE+1)+2-i, j*(SQUARE+1)+2-j, circle);
-	field->at(i,j) = CIRCLE;
-	field->isPernament(i, j) = true;
-	brain->zobristKey ^= brain->zobristCodes[i][j][0];
-	brain->zobristKey ^= brain->zobristCodes[i][j][CIRCLE];
+	view->drawStone(i, j, CIRCLE);
+	present();
+	recordMove(i, j, CIRCLE);
+	field->set(i, j, CIRCLE);
+	field->setPernament(i, j, true);
 }
 
 void Application::putCross(int i, int j) {
-	putSprite(i*(SQUARE+1)+2-i, j*(SQUARE+1)+2-j, cross);
-	field->at(i,j) = CROSS;
-	field->isPernament(i, j) = true;
-	brain->zobristKey ^= brain->zobristCodes[i][j][0];
-	brain->zobristKey ^= brain->zobristCodes[i][j][CROSS];
+	view->drawStone(i, j, CROSS);
+	present();
+	recordMove(i, j, CROSS);
+	field->set(i, j, CROSS);
+	field->setPernament(i, j, true);
+}
+
+/* the first move starts the record, the brain plays the crosses and in the demo the circles too */
+void Application::recordMove(int i, int j, int player) {
+	if (!game.header.numMoves) {
+		RecordEngine engine = {MOVETIME, 0, 0, 0};
+		game.start(NUMCOLS, NUMROWS, player, &engine, playingDemo ? &engine : NULL, false);
+	}
+	game.add(i, j);
 }
 
 void Application::run() {
 	MSG msg;
-	while (TRUE) {
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-			if (msg.message == WM_QUIT) break;
+	while (GetMessage(&msg, NULL, 0, 0) > 0) {  // pondering goes on in the brain's own thread meanwhile
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+ }
+
+void Application::think(int player, int* i, int* j) {
+	MSG msg;
+	if (!brain->ponderHit(*i, *j, MOVETIME))
+		brain->startSearch(player, MOVETIME);
+	while (brain->isSearching()) {
+		MsgWaitForMultipleObjects(0, NULL, FALSE, 10, QS_ALLINPUT);
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+			if (msg.message == WM_QUIT) {
+				brain->cancelSearch();
+				brain->waitSearch(i, j);
+				exit(0);
+			}
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
-		Sleep(50);
 	}
- }
+	brain->waitSearch(i, j);
+}
 
-void Application::renderDesk() {
-	SelectObject(hdc, brush);
-	SelectObject(hdc, pen);
-	for (int i = 0; i < SIZEX; i += SQUARE)
-		for (int j = 0; j < SIZEY - SQUARE; j += SQUARE) {
-			Rectangle(hdc, i, j, i + SQUARE + 1, j + SQUARE + 1);
-		}
-	for (int i = 0; i < NUMCOLS; i++)
-		for (int j = 0; j < NUMROWS; j++) {
-			if (field->at(i,j) == CROSS && field->isPernament(i, j))
-				putCross(i,j);
-			else if (field->at(i,j) == CIRCLE && field->isPernament(i, j))
-				putCircle(i,j);
-		}
+void Application::present() {
+	if (!hdc) return;
+	std::vector<Rect> rects;
+	view->takeDirty(&rects);
+	for (size_t r = 0; r < rects.size(); r++)
+		BitBlt(hdc, rects[r].left, rects[r].top, rects[r].right - rects[r].left, rects[r].bottom - rects[r].top,
+			memDC, rects[r].left, rects[r].top, SRCCOPY);
+	GdiFlush();
 }
 
-void Application::clearDesk() {
-	SelectObject(hdc, brush);
-	SelectObject(hdc, pen);
-	for (int i = 0; i < SIZEX; i += SQUARE)
-		for (int j = 0; j < SIZEY - SQUARE; j += SQUARE) {
-			Rectangle(hdc, i, j, i + SQUARE + 1, j + SQUARE + 1);
-		}
+void Application::clearDesk(int result) {
+	if (recording && game.header.numMoves) {
+		game.finish(result);
+		records.write(&game);
+		records.flush();
+	}
+	game.start(NUMCOLS, NUMROWS, CROSS, NULL, NULL, false);  // empty until the first move
+	view->drawDesk();
+	hoverI = hoverJ = -1;
+	present();
 	for (int i = 0; i < NUMCOLS; i++)
 		for (int j = 0; j < NUMROWS; j++) {
-			field->at(i,j) = 0;
+			field->set(i, j, 0);
 		}
 	brain->initTransTable();
 }
 
-void Application::putSprite(int x, int y, char *sprite) {
-	int j = 0;
-	for (int c = 0; c < SPRITESIZE * SPRITESIZE; c++) {
-		if (sprite[c] == 1)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(200, 0, 0));
-		if (sprite[c] == 2)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(230, 0, 0));
-		if (sprite[c] == 3)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(100, 0, 0));
-		if (sprite[c] == 4)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(80, 80, 220));
-		if (sprite[c] == 5)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(100, 100, 250));
-		if (sprite[c] == 6)
-			SetPixel(hdc, x + c % SPRITESIZE, y + j, RGB(80, 80, 220));
-		if (((c+1) % SPRITESIZE) == 0) j++;
-	}
-}
-
 void Application::showScore() {
 	static HWND lblCircle = NULL;
 	static HWND lblCross = NULL;
@@ -747,12 +330,13 @@ void Application::showScore() {
 	char strCross[100] = ": ";
 	itoa(scoreCircle, &strCircle[2], 10);
 	itoa(scoreCross, &strCross[2], 10);
-	putSprite(298, 417, circle);
+	view->drawSprite(298, 417, CIRCLE);
 	if (!lblCircle) 
 		lblCircle = CreateWindowEx(0, "STATIC", strCircle, WS_CHILD | WS_VISIBLE, 318, 416, 30, 30, hwnd, NULL, NULL, NULL);
 	else
 		SendMessage(lblCircle, WM_SETTEXT, 0, (LPARAM) strCircle);
-	putSprite(350, 417, cross);
+	view->drawSprite(350, 417, CROSS);
+	present();
 	if (!lblCross)
 		lblCross = CreateWindowEx(0, "STATIC", strCross, WS_CHILD | WS_VISIBLE, 370, 416, 30, 30, hwnd, NULL, NULL, NULL);
 	else
@@ -760,30 +344,29 @@ void Application::showScore() {
 }
 
 void Application::showVictory(int vi, int vj, int direction) {
-	HBRUSH tmpbrush = CreateSolidBrush(LINECOL);
-	FrameRect(hdc, &oldrect, tmpbrush);
-	DeleteObject(tmpbrush);
+	if (hoverI >= 0) view->frameSquare(hoverI, hoverJ, LINECOL);
+	hoverI = hoverJ = -1;
 	for (int l = 0; l < 10; l++)
 		for (int k = 0; k < 5; k++) {
-			int x, y;
+			int i, j;
 			if (direction == 1) {
-				x = (vi + k) * SQUARE;  
-				y = (vj) * SQUARE;
+				i = vi + k;
+				j = vj;
 			}
 			else if (direction == 2) {
-				x = (vi) * SQUARE;  
-				y = (vj + k) * SQUARE;
+				i = vi;
+				j = vj + k;
 			}
 			else if (direction == 3) {
-				x = (vi + k) * SQUARE;  
-				y = (vj + k) * SQUARE;
+				i = vi + k;
+				j = vj + k;
 			}
 			else {
-				x = (vi - k) * SQUARE;  
-				y = (vj + k) * SQUARE;
+				i = vi - k;
+				j = vj + k;
 			}
-			RECT rect = {x, y, x + SQUARE + 1, y + SQUARE + 1};
-			FrameRect(hdc, &rect, (HBRUSH) GetStockObject(WHITE_BRUSH));
+			view->frameSquare(i, j, FRAMECOL);
+			present();
 			Sleep(40);
 		}
 }
@@ -793,40 +376,44 @@ void Application::playDemo() {
 	int cnt = 0;
 	idle = false;
 	while (playingDemo) {
-		if (cnt++ == 0)
-			putCircle((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
-		else {
-			brain->getBestMove(CIRCLE, &i, &j);
+		if (cnt++ == 0) {
+			i = (rand() % (NUMCOLS - 10)) + 5;
+			j = (rand() % (NUMROWS - 10)) + 5;
+			putCircle(i, j);
+		} else {
+			think(CIRCLE, &i, &j);
 			putCircle(i, j);
 		}
 		int vi, vj, direction;
 		if (brain->isDraw()) {
-			clearDesk();
+			Sleep(1000);
+			clearDesk(RECORDDRAW);
 			if (++gameCount % 2 == 1)
 				putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 		}
-		if (brain->isVictory(CIRCLE, &vi, &vj, &direction)) {
+		if (brain->isVictory(CIRCLE, i, j, &vi, &vj, &direction)) {
 			showVictory(vi, vj, direction);
 			scoreCircle++;
-			clearDesk();
+			clearDesk(CIRCLE);
 			showScore();
 			if (++gameCount % 2 == 1)
 				putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 			else
 				putCircle((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 		} else {
-			brain->getBestMove(CROSS, &i, &j);
+			think(CROSS, &i, &j);
 			putCross(i, j);
 		}
 		if (brain->isDraw()) {
-			clearDesk();
+			Sleep(1000);
+			clearDesk(RECORDDRAW);
 			if (++gameCount % 2 == 1)
 				putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
 		}
-		if (brain->isVictory(CROSS, &vi, &vj, &direction)) {
+		if (brain->isVictory(CROSS, i, j, &vi, &vj, &direction)) {
 			showVictory(vi, vj, direction);
 			scoreCross++;
-			clearDesk();
+			clearDesk(CROSS);
 			showScore();
 			if (++gameCount % 2 == 1)
 				putCross((rand() % (NUMCOLS - 10)) + 5, (rand() % (NUMROWS - 10)) + 5);
@@ -838,8 +425,10 @@ void Application::playDemo() {
 }
 
 Application::~Application() {
-	DeleteObject(brush);
 	ReleaseDC(hwnd, hdc);
+	delete view;
+	DeleteDC(memDC);
+	DeleteObject(bitmap);
 	if (brain) delete brain;
 	if (field) delete field;
 }
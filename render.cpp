@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <string.h>
+#include "brain.h"
+#include "render.h"
+
+/***********************************************************************************************/
+
+static const char circle[] = {
+	00, 00, 00, 00, 00, 00, 06, 06, 06, 06, 06, 00, 00, 00, 00, 00, 00,
+	00, 00, 00, 00, 06, 05, 05, 05, 05, 05, 05, 05, 06, 00, 00, 00, 00,
+	00, 00, 00, 06, 05, 04, 04, 04, 04, 04, 04, 04, 05, 06, 00, 00, 00,
+	00, 00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00, 00,
+	00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00,
+	00, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 00,
+	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
+	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
+	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
+	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
+	06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06,
+	00, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 00,
+	00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00,
+	00, 00, 06, 05, 04, 00, 00, 00, 00, 00, 00, 00, 04, 05, 06, 00, 00,
+	00, 00, 00, 06, 05, 04, 04, 04, 04, 04, 04, 04, 05, 06, 00, 00, 00,
+	00, 00, 00, 00, 06, 05, 05, 05, 05, 05, 05, 05, 06, 00, 00, 00, 00,
+	00, 00, 00, 00, 00, 00, 06, 06, 06, 06, 06, 00, 00, 00, 00, 00, 00,
+
+};
+
+static const char cross[] = {
+	00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00,
+	00, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 00,
+	00, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 00,
+	00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00,
+	00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00,
+	00, 00, 00, 03, 02, 01, 02, 03, 00, 03, 02, 01, 02, 03, 00, 00, 00,
+	00, 00, 00, 00, 03, 02, 01, 02, 03, 02, 01, 02, 03, 00, 00, 00, 00,
+	00, 00, 00, 00, 00, 03, 02, 01, 02, 01, 02, 03, 00, 00, 00, 00, 00,
+	00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00,
+	00, 00, 00, 00, 00, 03, 02, 01, 02, 01, 02, 03, 00, 00, 00, 00, 00,
+	00, 00, 00, 00, 03, 02, 01, 02, 03, 02, 01, 02, 03, 00, 00, 00, 00,
+	00, 00, 00, 03, 02, 01, 02, 03, 00, 03, 02, 01, 02, 03, 00, 00, 00,
+	00, 00, 03, 02, 01, 02, 03, 00, 00, 00, 03, 02, 01, 02, 03, 00, 00,
+	00, 03, 02, 01, 02, 03, 00, 00, 00, 00, 00, 03, 02, 01, 02, 03, 00,
+	00, 02, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 02, 00,
+	00, 01, 02, 03, 00, 00, 00, 00, 00, 00, 00, 00, 00, 03, 02, 01, 00,
+	00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00, 00
+};
+
+/* the colors of the sprites, 0 is transparent */
+static const unsigned palette[7] = {
+	0, RGBCOLOR(200, 0, 0), RGBCOLOR(230, 0, 0), RGBCOLOR(100, 0, 0),
+	RGBCOLOR(80, 80, 220), RGBCOLOR(100, 100, 250), RGBCOLOR(80, 80, 220)
+};
+
+/***********************************************************************************************/
+
+Renderer::Renderer(int cols, int rows, int width, int height, unsigned* pixels) {
+	this->cols = cols;
+	this->rows = rows;
+	this->width = width;
+	this->height = height;
+	ownPixels = !pixels;
+	this->pixels = pixels ? pixels : new unsigned[width * height];
+	// the sprites are rasterized once, drawing a stone only copies them
+	memset(sprites, 0, sizeof(sprites));
+	for (int c = 0; c < SPRITESIZE * SPRITESIZE; c++) {
+		sprites[CIRCLE][c] = palette[(int) circle[c]];
+		sprites[CROSS][c] = palette[(int) cross[c]];
+	}
+	Rect all = {0, 0, width, height};
+	fill(&all, WINDOWCOL);
+	drawDesk();
+}
+
+Renderer::~Renderer() {
+	if (ownPixels) delete[] pixels;
+}
+
+void Renderer::fill(const Rect* rect, unsigned color) {
+	int left = rect->left > 0 ? rect->left : 0;
+	int top = rect->top > 0 ? rect->top : 0;
+	int right = rect->right < width ? rect->right : width;
+	int bottom = rect->bottom < height ? rect->bottom : height;
+	for (int y = top; y < bottom; y++)
+		for (int x = left; x < right; x++)
+			pixels[y * width + x] = color;
+	addDirty(rect);
+}
+
+/* the square covers its lines on all four sides, they are shared with the neighbours */
+void Renderer::drawSquare(int i, int j) {
+	Rect lines = {i * SQUARE, j * SQUARE, (i + 1) * SQUARE + 1, (j + 1) * SQUARE + 1};
+	Rect inside = {lines.left + 1, lines.top + 1, lines.right - 1, lines.bottom - 1};
+	fill(&lines, LINECOL);
+	fill(&inside, BGCOL);
+}
+
+void Renderer::drawDesk() {
+	for (int i = 0; i < cols; i++)
+		for (int j = 0; j < rows; j++)
+			drawSquare(i, j);
+}
+
+/* the lines stay as they are, a frame drawn around the square is kept */
+void Renderer::drawStone(int i, int j, int item) {
+	Rect inside = {i * SQUARE + 1, j * SQUARE + 1, (i + 1) * SQUARE, (j + 1) * SQUARE};
+	fill(&inside, BGCOL);
+	if (item) drawSprite(i * SQUARE + SPRITEOFFSET, j * SQUARE + SPRITEOFFSET, item);
+}
+
+void Renderer::drawSprite(int x, int y, int item) {
+	const unsigned* sprite = sprites[item];
+	for (int sy = 0; sy < SPRITESIZE; sy++) {
+		if (y + sy < 0 || y + sy >= height) continue;
+		unsigned* row = &pixels[(y + sy) * width];
+		for (int sx = 0; sx < SPRITESIZE; sx++) {
+			unsigned color = sprite[sy * SPRITESIZE + sx];
+			if ((color >> 24) && x + sx >= 0 && x + sx < width) row[x + sx] = color;
+		}
+	}
+	Rect rect = {x, y, x + SPRITESIZE, y + SPRITESIZE};
+	addDirty(&rect);
+}
+
+void Renderer::frameSquare(int i, int j, unsigned color) {
+	int left = i * SQUARE, top = j * SQUARE;
+	Rect sides[4] = {
+		{left, top, left + SQUARE + 1, top + 1}, {left, top + SQUARE, left + SQUARE + 1, top + SQUARE + 1},
+		{left, top, left + 1, top + SQUARE + 1}, {left + SQUARE, top, left + SQUARE + 1, top + SQUARE + 1}
+	};
+	for (int k = 0; k < 4; k++)
+		fill(&sides[k], color);
+}
+
+/***********************************************************************************************/
+
+/* a rectangle overlapping or touching one already kept is merged with it, and the result again,
+   so that a move and the frames around it are copied at once */
+void Renderer::addDirty(const Rect* rect) {
+	Rect r = *rect;
+	if (r.left < 0) r.left = 0;
+	if (r.top < 0) r.top = 0;
+	if (r.right > width) r.right = width;
+	if (r.bottom > height) r.bottom = height;
+	if (r.left >= r.right || r.top >= r.bottom) return;
+	for (size_t k = 0; k < dirty.size(); ) {
+		const Rect* d = &dirty[k];
+		if (d->left > r.right || r.left > d->right || d->top > r.bottom || r.top > d->bottom) {
+			k++;
+			continue;
+		}
+		if (d->left < r.left) r.left = d->left;
+		if (d->top < r.top) r.top = d->top;
+		if (d->right > r.right) r.right = d->right;
+		if (d->bottom > r.bottom) r.bottom = d->bottom;
+		dirty.erase(dirty.begin() + k);
+		k = 0;                      // the larger rectangle may reach others now
+	}
+	if ((int) dirty.size() == MAXDIRTY - 1) {
+		for (size_t k = 0; k < dirty.size(); k++) {
+			if (dirty[k].left < r.left) r.left = dirty[k].left;
+			if (dirty[k].top < r.top) r.top = dirty[k].top;
+			if (dirty[k].right > r.right) r.right = dirty[k].right;
+			if (dirty[k].bottom > r.bottom) r.bottom = dirty[k].bottom;
+		}
+		dirty.clear();
+	}
+	dirty.push_back(r);
+}
+
+void Renderer::takeDirty(std::vector<Rect>* rects) {
+	rects->swap(dirty);
+	dirty.clear();
+}
+
+/***********************************************************************************************/
+
+bool Renderer::writePPM(const char* fileName) {
+	FILE* f = fopen(fileName, "wb");
+	if (!f) return false;
+	fprintf(f, "P6\n%d %d\n255\n", width, height);
+	std::vector<unsigned char> line(3 * width);
+	bool written = true;
+	for (int y = 0; y < height && written; y++) {
+		for (int x = 0; x < width; x++) {
+			unsigned color = pixels[y * width + x];
+			line[3*x] = (unsigned char) (color >> 16);
+			line[3*x + 1] = (unsigned char) (color >> 8);
+			line[3*x + 2] = (unsigned char) color;
+		}
+		written = fwrite(&line[0], 1, line.size(), f) == line.size();
+	}
+	return fclose(f) == 0 && written;
+}
+
+static unsigned crc32(unsigned crc, const unsigned char* data, size_t n) {
+	static unsigned table[256];
+	if (!table[1]) {
+		for (unsigned k = 0; k < 256; k++) {
+			unsigned c = k;
+			for (int b = 0; b < 8; b++)
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[k] = c;
+		}
+	}
+	crc = ~crc;
+	for (size_t k = 0; k < n; k++)
+		crc = table[(crc ^ data[k]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void putBig(std::vector<unsigned char>* out, unsigned value) {
+	for (int b = 3; b >= 0; b--)
+		out->push_back((unsigned char) (value >> 8*b));
+}
+
+static bool writeChunk(FILE* f, const char* type, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> chunk;
+	putBig(&chunk, (unsigned) data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	putBig(&chunk, crc32(0, &chunk[4], chunk.size() - 4));
+	return fwrite(&chunk[0], 1, chunk.size(), f) == chunk.size();
+}
+
+/* RGB rows without a filter in a zlib stream of stored deflate blocks, readable by any viewer
+   and needing no compression library */
+bool Renderer::writePNG(const char* fileName) {
+	std::vector<unsigned char> raw;
+	raw.reserve((3 * width + 1) * height);
+	for (int y = 0; y < height; y++) {
+		raw.push_back(0);
+		for (int x = 0; x < width; x++) {
+			unsigned color = pixels[y * width + x];
+			raw.push_back((unsigned char) (color >> 16));
+			raw.push_back((unsigned char) (color >> 8));
+			raw.push_back((unsigned char) color);
+		}
+	}
+	std::vector<unsigned char> zlib;
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	for (size_t start = 0; start < raw.size() || start == 0; start += 65535) {
+		size_t n = raw.size() - start < 65535 ? raw.size() - start : 65535;
+		zlib.push_back(start + n == raw.size() ? 1 : 0);  // the last block is marked
+		zlib.push_back((unsigned char) n);
+		zlib.push_back((unsigned char) (n >> 8));
+		zlib.push_back((unsigned char) ~n);
+		zlib.push_back((unsigned char) (~n >> 8));
+		zlib.insert(zlib.end(), raw.begin() + start, raw.begin() + start + n);
+	}
+	unsigned a = 1, b = 0;          // adler32 of the rows
+	for (size_t k = 0; k < raw.size(); k++) {
+		a = (a + raw[k]) % 65521;
+		b = (b + a) % 65521;
+	}
+	putBig(&zlib, b << 16 | a);
+	std::vector<unsigned char> header;
+	putBig(&header, width);
+	putBig(&header, height);
+	header.push_back(8);            // bits per channel
+	header.push_back(2);            // RGB
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	FILE* f = fopen(fileName, "wb");
+	if (!f) return false;
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	bool written = fwrite(signature, 1, 8, f) == 8 && writeChunk(f, "IHDR", header)
+		&& writeChunk(f, "IDAT", zlib) && writeChunk(f, "IEND", std::vector<unsigned char>());
+	return fclose(f) == 0 && written;
+}
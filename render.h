@@ -0,0 +1,58 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+/* the picture of the game drawn in memory, free of any platform dependency: the desk, the stones and the
+   frames go into a framebuffer and the parts which changed are collected as dirty rectangles, so that the
+   window only copies those to the screen; snapshots are written as PPM or PNG */
+
+#include <vector>
+
+#define SQUARE 20                   // size of the square
+#define SPRITESIZE 17               // x or y size of sprite
+#define SPRITEOFFSET 2              // of the sprite from the corner of its square
+#define RGBCOLOR(r, g, b) (0xff000000u | (r) << 16 | (g) << 8 | (b))
+#define LINECOL RGBCOLOR(100, 100, 100)  // line color for the desk
+#define BGCOL RGBCOLOR(219, 178, 113)    // background color of the desk
+#define WINDOWCOL RGBCOLOR(255, 255, 255)  // around the desk
+#define FRAMECOL RGBCOLOR(255, 255, 255)   // the square under the mouse and the five which won
+#define MAXDIRTY 16                 // dirty rectangles kept apart before they are merged into one
+
+/***********************************************************************************************/
+
+struct Rect {                       // right and bottom are excluded
+	int left;
+	int top;
+	int right;
+	int bottom;
+};
+
+class Renderer {                    // draws the desk of cols by rows squares at the top left of the buffer
+	int cols;
+	int rows;
+	bool ownPixels;
+	unsigned sprites[3][SPRITESIZE*SPRITESIZE];  // the stones of CIRCLE and CROSS rasterized, alpha 0 is transparent
+	std::vector<Rect> dirty;
+	void drawSquare(int i, int j);  // the empty square with its lines
+public:
+	/* 32 bits per pixel, 0xaarrggbb, rows from the top: the layout of a top-down 32-bit Windows DIB */
+	unsigned* pixels;
+	int width;
+	int height;
+	/* draw into pixels if given, which must hold width*height, else into a buffer of its own;
+	   the buffer starts as the empty desk in WINDOWCOL */
+	Renderer(int cols, int rows, int width, int height, unsigned* pixels = 0);
+	~Renderer();
+	void fill(const Rect* rect, unsigned color);
+	void drawDesk();                // the empty desk, the rest of the buffer is left as it is
+	void drawStone(int i, int j, int item);  // CIRCLE, CROSS or 0 for the empty square
+	void drawSprite(int x, int y, int item);  // a stone anywhere, its corner at x,y
+	void frameSquare(int i, int j, unsigned color);  // the lines around the square i,j, LINECOL restores them
+	void addDirty(const Rect* rect);
+	/* move the rectangles which changed since the last call to rects, fewer than MAXDIRTY,
+	   overlapping ones merged */
+	void takeDirty(std::vector<Rect>* rects);
+	bool writePPM(const char* fileName);
+	bool writePNG(const char* fileName);  // uncompressed, the deflate stream is stored
+};
+
+#endif
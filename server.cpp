@@ -0,0 +1,572 @@
+/* server: hosts many games at once on a fixed pool of engines sharing one transposition table, driven by
+   a line protocol on stdin and stdout or on a Unix socket; POSIX only, the engine itself stays portable */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <condition_variable>
+#include "brain.h"
+
+#define SERVERMEMORY 256            // default memory cap in MB
+#define SERVERSESSIONS 1000         // default limit of the open games
+#define MINTABLE (1 << 20)          // bytes the transposition table needs at least
+#define MINSLICE 10                 // ms every search is given, even one which could not start before its deadline
+#define SLICESHARE 4                // a waiting search takes an engine once only 1/SLICESHARE of its time is left
+#define MAXMOVETIME 600000          // ms of the longest search
+#define LATEMARGIN 5                // ms a move may follow its deadline without being counted late
+
+/***********************************************************************************************/
+
+struct Connection {                 // a client, or stdin and stdout
+	int in;
+	int out;
+	std::string input;              // received but not yet complete line
+	std::vector<int> sessions;      // opened by the client, freed when it goes away
+};
+
+struct Session {                    // one game
+	int id;
+	Connection* connection;         // the moves found are sent there
+	Field field;
+	int player;                     // to move
+	bool over;                      // won or drawn
+	bool busy;                      // a search is queued or running
+	GameRecord record;              // the moves so far, written once the game is over
+};
+
+struct Job {                        // a search of a session waiting for an engine or running on one
+	int session;
+	int moveTime;                   // ms
+	long long deadline;             // us of the steady clock
+	long long latestStart;          // from then on it cuts short a running search with a later deadline
+};
+
+class Server;
+
+struct Engine {
+	Server* server;
+	Field* field;                   // the position of the job, a copy of the field of its session
+	Brain* brain;
+	bool busy;
+	bool cut;                       // the search was cancelled to free the engine
+	Job job;
+	long long started;
+};
+
+/***********************************************************************************************/
+
+class Server {
+	int numEngines;
+	int maxSessions;
+	long long memory;               // bytes
+	unsigned long long seed;
+	const char* bookName;
+	const char* weightsName;        // the values of the blocks, NULL for the built-in ones
+	const char* socketName;         // NULL for stdin and stdout
+	const char* recordsName;        // the finished games are appended there, NULL if they are not kept
+	RecordWriter records;
+	TransTable* transTable;
+	Engine* engines;
+	std::mutex lock;                // guards everything below, taken by the commands, the scheduler and the engines
+	std::condition_variable wake;   // a job was queued or an engine has finished
+	std::map<int, Session*> sessions;
+	int nextId;
+	std::vector<Job> queue;
+	bool stopping;
+	unsigned long long searches;    // finished
+	unsigned long long late;        // of those, moves sent more than LATEMARGIN ms after the deadline
+	long long maxLate;              // us
+	unsigned long long cuts;        // searches cut short for a more urgent one
+	std::thread scheduler;
+	static long long now();
+	static long long sliceOf(const Job* job);  // us a search keeps its engine before it can be cut short
+	void schedule();                // the body of the scheduler thread
+	void startJob(Engine* engine, const Job* job, long long t);
+	void cutSearch(const Job* waiting, long long t);  // free an engine for waiting if a running search is less urgent
+	static void searchDone(void* data, int i, int j);
+	void finish(Engine* engine, int i, int j);
+	void send(Connection* c, const char* format, ...);
+	/* place the stone of the player to move, " win", " draw" or ""; score and depth are of the search finding it */
+	const char* play(Session* session, int i, int j, int score = 0, int depth = 0);
+	void command(Connection* c, const char* line);
+	Session* findSession(Connection* c, int id);
+	void freeSession(int id);
+	void closeConnection(Connection* c);
+	bool receive(Connection* c);    // read and execute the commands, false once the input has ended
+	void serveStdio();
+	bool serveSocket();
+public:
+	Server();
+	~Server();
+	bool parse(int argc, char** argv);
+	bool start();
+	bool serve();                   // answer the clients until the input ends, false if the socket cannot be opened
+};
+
+/***********************************************************************************************/
+
+Server::Server() {
+	numEngines = std::thread::hardware_concurrency();
+	if (numEngines < 1) numEngines = 1;
+	maxSessions = SERVERSESSIONS;
+	memory = SERVERMEMORY * 1024LL * 1024;
+	seed = (unsigned long long) time(NULL);
+	bookName = NULL;
+	weightsName = NULL;
+	socketName = NULL;
+	recordsName = NULL;
+	transTable = NULL;
+	engines = NULL;
+	nextId = 1;
+	stopping = false;
+	searches = 0;
+	late = 0;
+	maxLate = 0;
+	cuts = 0;
+}
+
+Server::~Server() {
+	lock.lock();
+	stopping = true;
+	lock.unlock();
+	wake.notify_all();
+	if (scheduler.joinable())
+		scheduler.join();
+	// the engines are deleted without the lock, their searches still report to finish
+	for (int e = 0; engines && e < numEngines; e++) {
+		delete engines[e].brain;
+		delete engines[e].field;
+	}
+	delete[] engines;
+	delete transTable;
+	if (!records.close()) fprintf(stderr, "the game records could not be written\n");
+	for (std::map<int, Session*>::iterator s = sessions.begin(); s != sessions.end(); ++s)
+		delete s->second;
+}
+
+bool Server::parse(int argc, char** argv) {
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-engines")) numEngines = atoi(value);
+		else if (!strcmp(arg, "-sessions")) maxSessions = atoi(value);
+		else if (!strcmp(arg, "-memory")) memory = atoll(value) * 1024 * 1024;
+		else if (!strcmp(arg, "-seed")) seed = strtoull(value, NULL, 10);
+		else if (!strcmp(arg, "-book")) bookName = value;
+		else if (!strcmp(arg, "-weights")) weightsName = value;
+		else if (!strcmp(arg, "-socket")) socketName = value;
+		else if (!strcmp(arg, "-records")) recordsName = value;
+		else return false;
+	}
+	return numEngines >= 1 && maxSessions >= 1;
+}
+
+/* the engines and the games are taken from the memory cap first, the transposition table gets the rest */
+bool Server::start() {
+	long long engineBytes = sizeof(Brain) + sizeof(Field) + sizeof(BasicSearcher<NUMCOLS, NUMROWS>)
+		+ sizeof(BasicThreatSearch<NUMCOLS, NUMROWS>);
+	long long tableBytes = memory - numEngines * engineBytes - maxSessions * (long long) sizeof(Session);
+	if (tableBytes < MINTABLE) {
+		fprintf(stderr, "%lld MB do not hold %d engines and %d games\n", memory >> 20, numEngines, maxSessions);
+		return false;
+	}
+	if (recordsName && !records.open(recordsName)) {
+		fprintf(stderr, "%s is not a game record file or ends with an incomplete game\n", recordsName);
+		return false;
+	}
+	transTable = new TransTable(TransTable::sizeFor(tableBytes));
+	engines = new Engine[numEngines]();  // no brains yet if one of them fails
+	for (int e = 0; e < numEngines; e++) {
+		Engine* engine = &engines[e];
+		engine->server = this;
+		engine->field = new Field();
+		engine->brain = new Brain(engine->field, transTable);
+		engine->brain->setThreads(1);
+		engine->brain->setSeed(seed);   // the same zobrist codes for all, they share the table
+		if (bookName) engine->brain->setBook(bookName);
+		if (weightsName && !engine->brain->setWeights(weightsName)) {
+			fprintf(stderr, "cannot read %s\n", weightsName);
+			return false;
+		}
+		engine->busy = false;
+		engine->cut = false;
+	}
+	fprintf(stderr, "%d engines, %d games, %lld MB of transposition table\n", numEngines, maxSessions, tableBytes >> 20);
+	scheduler = std::thread(&Server::schedule, this);
+	return true;
+}
+
+long long Server::now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long Server::sliceOf(const Job* job) {
+	long long slice = job->moveTime * 1000LL / SLICESHARE;
+	return slice > MINSLICE * 1000LL ? slice : MINSLICE * 1000LL;
+}
+
+/***********************************************************************************************/
+
+/* earliest deadline first: a free engine takes the most urgent job, and when a job has to start and no engine
+   is free, the running search with the latest deadline is cut short once it has had its slice; it still plays
+   the best move of its last iteration */
+void Server::schedule() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (!stopping) {
+		long long t = now();
+		long long wakeAt = 0;
+		for (int e = 0; e < numEngines && !queue.empty(); e++) {
+			if (engines[e].busy) continue;
+			int first = 0;
+			for (int k = 1; k < (int) queue.size(); k++)
+				if (queue[k].deadline < queue[first].deadline) first = k;
+			Job job = queue[first];
+			queue.erase(queue.begin() + first);
+			startJob(&engines[e], &job, t);
+		}
+		if (!queue.empty()) {
+			const Job* first = &queue[0];
+			for (int k = 1; k < (int) queue.size(); k++)
+				if (queue[k].deadline < first->deadline) first = &queue[k];
+			if (t >= first->latestStart) {
+				cutSearch(first, t);
+				wakeAt = t + MINSLICE * 1000LL / 4;  // look again if nothing could be cut yet
+			} else
+				wakeAt = first->latestStart;
+		}
+		if (wakeAt)
+			wake.wait_for(guard, std::chrono::microseconds(wakeAt - t));
+		else
+			wake.wait(guard);
+	}
+}
+
+/* a search may use the time up to its deadline, but while more searches are waiting than there are engines it gets
+   its share of them, so that the games keep their pace together instead of the last ones in the queue running late */
+void Server::startJob(Engine* engine, const Job* job, long long t) {
+	Session* session = sessions[job->session];
+	int searching = (int) queue.size() + 1;
+	for (int e = 0; e < numEngines; e++)
+		if (engines[e].busy) searching++;
+	long long budget = job->deadline - t;
+	long long share = job->moveTime * 1000LL * numEngines / searching;
+	if (budget > share) budget = share;
+	if (budget < MINSLICE * 1000LL) budget = MINSLICE * 1000LL;
+	*engine->field = session->field;
+	engine->busy = true;
+	engine->cut = false;
+	engine->job = *job;
+	engine->started = t;
+	// the previous search of the engine has left finish, so startSearch can join its thread under the lock
+	engine->brain->startSearch(session->player, (int) ((budget + 999) / 1000), searchDone, engine);
+}
+
+void Server::cutSearch(const Job* waiting, long long t) {
+	Engine* latest = NULL;
+	for (int e = 0; e < numEngines; e++) {
+		Engine* engine = &engines[e];
+		if (!engine->busy || engine->cut || engine->job.deadline <= waiting->deadline) continue;
+		if (t - engine->started < sliceOf(&engine->job)) continue;
+		if (!latest || engine->job.deadline > latest->job.deadline) latest = engine;
+	}
+	if (latest) {
+		latest->cut = true;
+		latest->brain->cancelSearch();
+		cuts++;
+	}
+}
+
+void Server::searchDone(void* data, int i, int j) {
+	Engine* engine = (Engine*) data;
+	engine->server->finish(engine, i, j);
+}
+
+void Server::finish(Engine* engine, int i, int j) {
+	lock.lock();
+	long long t = now();
+	searches++;
+	if (t - engine->job.deadline > LATEMARGIN * 1000LL) late++;
+	if (t - engine->job.deadline > maxLate) maxLate = t - engine->job.deadline;
+	std::map<int, Session*>::iterator s = sessions.find(engine->job.session);
+	if (s != sessions.end()) {      // the game may have been freed meanwhile
+		Session* session = s->second;
+		session->busy = false;
+		RecordEngine* config = &session->record.header.engines[session->player == CROSS ? 0 : 1];
+		config->moveTime = engine->job.moveTime;  // of the last search, the client may vary it
+		config->threads = 1;
+		SearchInfo info;
+		engine->brain->getSearchInfo(&info);
+		const char* result = play(session, i, j, info.price, info.depth);
+		send(session->connection, "move %d %d %d%s\n", session->id, i, j, result);
+	}
+	engine->busy = false;
+	lock.unlock();
+	wake.notify_all();
+}
+
+/***********************************************************************************************/
+
+void Server::send(Connection* c, const char* format, ...) {
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	if (length >= (int) sizeof(text)) length = sizeof(text) - 1;
+	// a client which has gone away is noticed by the reading side
+	for (int sent = 0; sent < length; ) {
+		int n = (int) write(c->out, text + sent, length - sent);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		sent += n;
+	}
+}
+
+const char* Server::play(Session* session, int i, int j, int score, int depth) {
+	Field* field = &session->field;
+	int player = session->player;
+	field->set(i, j, player);
+	session->record.add(i, j, score, depth);
+	session->player = (player == CIRCLE) ? CROSS : CIRCLE;
+	int winner = 0;
+	const char* result = "";
+	if (field->isFive(player, i, j, NULL, NULL, NULL)) {
+		winner = player;
+		result = " win";
+	} else if (field->frontierSize == 0) {
+		winner = RECORDDRAW;
+		result = " draw";
+	}
+	session->over = winner != 0;
+	if (session->over && recordsName) {
+		session->record.finish(winner);
+		records.write(&session->record);
+		records.flush();            // a server is rarely closed, so nothing waits in the buffer
+	}
+	return result;
+}
+
+Session* Server::findSession(Connection* c, int id) {
+	std::map<int, Session*>::iterator s = sessions.find(id);
+	if (s == sessions.end() || s->second->connection != c) {
+		send(c, "error no game %d\n", id);
+		return NULL;
+	}
+	return s->second;
+}
+
+void Server::freeSession(int id) {
+	std::map<int, Session*>::iterator s = sessions.find(id);
+	if (s == sessions.end()) return;
+	for (int k = 0; k < (int) queue.size(); k++)
+		if (queue[k].session == id) queue.erase(queue.begin() + k--);
+	for (int e = 0; e < numEngines; e++)
+		if (engines[e].busy && engines[e].job.session == id) engines[e].brain->cancelSearch();
+	std::vector<int>* owned = &s->second->connection->sessions;
+	for (int k = 0; k < (int) owned->size(); k++)
+		if ((*owned)[k] == id) owned->erase(owned->begin() + k--);
+	delete s->second;
+	sessions.erase(s);
+}
+
+/* new, play id i j, go id ms, stop id, free id, stats and quit; the search started by go answers later
+   with "move id i j", followed by win or draw when the move ends the game */
+void Server::command(Connection* c, const char* line) {
+	char name[16];
+	int id, a, b;
+	Session* session;
+	if (sscanf(line, "%15s", name) != 1) return;
+	int n = sscanf(line, "%*s %d %d %d", &id, &a, &b);
+	if (!strcmp(name, "new")) {
+		if ((int) sessions.size() >= maxSessions) {
+			send(c, "error %d games are open\n", maxSessions);
+			return;
+		}
+		session = new Session();
+		session->id = nextId++;
+		session->connection = c;
+		session->player = CROSS;
+		session->over = false;
+		session->busy = false;
+		session->record.start(NUMCOLS, NUMROWS, CROSS, NULL, NULL, true);
+		sessions[session->id] = session;
+		c->sessions.push_back(session->id);
+		send(c, "ok %d\n", session->id);
+	} else if (!strcmp(name, "play") && n == 3) {
+		if (!(session = findSession(c, id))) return;
+		if (session->busy) send(c, "error game %d is searching\n", id);
+		else if (session->over) send(c, "error game %d is over\n", id);
+		else if (a < 0 || a >= NUMCOLS || b < 0 || b >= NUMROWS || session->field.at(a, b))
+			send(c, "error illegal move\n");
+		else
+			send(c, "ok%s\n", play(session, a, b));
+	} else if (!strcmp(name, "go") && n == 2) {
+		if (!(session = findSession(c, id))) return;
+		if (session->busy) send(c, "error game %d is searching\n", id);
+		else if (session->over) send(c, "error game %d is over\n", id);
+		else if (a < 1 || a > MAXMOVETIME) send(c, "error time out of range\n");
+		else if (session->field.stones == 0)   // the engine does not search the empty field
+			send(c, "move %d %d %d%s\n", id, NUMCOLS / 2, NUMROWS / 2, play(session, NUMCOLS / 2, NUMROWS / 2));
+		else {
+			Job job;
+			job.session = id;
+			job.moveTime = a;
+			job.deadline = now() + a * 1000LL;
+			job.latestStart = job.deadline - sliceOf(&job);
+			queue.push_back(job);
+			session->busy = true;
+			wake.notify_all();
+		}
+	} else if (!strcmp(name, "stop") && n == 1) {
+		if (!(session = findSession(c, id))) return;
+		// a queued search becomes the most urgent one, a running one plays its best move
+		for (int k = 0; k < (int) queue.size(); k++)
+			if (queue[k].session == id) queue[k].deadline = queue[k].latestStart = now();
+		for (int e = 0; e < numEngines; e++)
+			if (engines[e].busy && engines[e].job.session == id) engines[e].brain->cancelSearch();
+		wake.notify_all();
+		send(c, "ok\n");
+	} else if (!strcmp(name, "free") && n == 1) {
+		if (!findSession(c, id)) return;
+		freeSession(id);
+		send(c, "ok\n");
+	} else if (!strcmp(name, "stats")) {
+		int running = 0;
+		for (int e = 0; e < numEngines; e++)
+			if (engines[e].busy) running++;
+		send(c, "stats games %d queued %d running %d searches %llu late %llu maxlate %lld cut %llu\n",
+			(int) sessions.size(), (int) queue.size(), running, searches, late, maxLate / 1000, cuts);
+	} else
+		send(c, "error unknown command\n");
+}
+
+void Server::closeConnection(Connection* c) {
+	while (!c->sessions.empty())
+		freeSession(c->sessions.back());
+}
+
+bool Server::receive(Connection* c) {
+	char buffer[4096];
+	int n;
+	do n = (int) read(c->in, buffer, sizeof(buffer));
+	while (n < 0 && errno == EINTR);
+	if (n > 0) c->input.append(buffer, n);
+	bool open = n > 0;
+	std::lock_guard<std::mutex> guard(lock);
+	for (size_t end; open && (end = c->input.find('\n')) != std::string::npos; ) {
+		std::string line = c->input.substr(0, end);
+		c->input.erase(0, end + 1);
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (line == "quit") open = false;
+		else command(c, line.c_str());
+	}
+	if (c->input.size() > 4096) open = false;  // no command is that long
+	return open;
+}
+
+/***********************************************************************************************/
+
+bool Server::serve() {
+	if (socketName) {
+		if (serveSocket()) return true;
+		fprintf(stderr, "cannot listen on %s\n", socketName);
+		return false;
+	}
+	serveStdio();
+	return true;
+}
+
+/* one client on stdin and stdout; the searches still running when the input ends are waited for */
+void Server::serveStdio() {
+	Connection c;
+	c.in = 0;
+	c.out = 1;
+	while (receive(&c));
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;) {
+		bool busy = false;
+		for (int k = 0; k < (int) c.sessions.size(); k++)
+			if (sessions[c.sessions[k]]->busy) busy = true;
+		if (!busy) break;
+		wake.wait(guard);
+	}
+	closeConnection(&c);
+}
+
+bool Server::serveSocket() {
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (listener < 0 || strlen(socketName) >= sizeof(address.sun_path)) return false;
+	strcpy(address.sun_path, socketName);
+	unlink(socketName);
+	if (bind(listener, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(listener, 64) < 0) {
+		close(listener);
+		return false;
+	}
+	signal(SIGPIPE, SIG_IGN);       // a client closing its end must not stop the server
+	std::vector<Connection*> clients;
+	std::vector<struct pollfd> polled;
+	for (;;) {
+		polled.resize(clients.size() + 1);
+		polled[0].fd = listener;
+		polled[0].events = POLLIN;
+		for (size_t k = 0; k < clients.size(); k++) {
+			polled[k + 1].fd = clients[k]->in;
+			polled[k + 1].events = POLLIN;
+		}
+		if (poll(&polled[0], polled.size(), -1) < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		for (size_t k = clients.size(); k > 0; k--) {
+			if (!(polled[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+			Connection* c = clients[k - 1];
+			if (receive(c)) continue;
+			lock.lock();
+			closeConnection(c);
+			lock.unlock();
+			close(c->in);
+			delete c;
+			clients.erase(clients.begin() + (k - 1));
+		}
+		if (polled[0].revents & POLLIN) {
+			int fd = accept(listener, NULL, NULL);
+			if (fd >= 0) {
+				Connection* c = new Connection();
+				c->in = c->out = fd;
+				clients.push_back(c);
+			}
+		}
+	}
+	close(listener);
+	unlink(socketName);
+	return true;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Server* server = new Server();
+	if (!server->parse(argc, argv)) {
+		printf("usage: server [-socket path] [-engines n] [-sessions n] [-memory MB] [-book file] [-weights file]\n"
+			"              [-records file] [-seed n]\n");
+		delete server;
+		return 1;
+	}
+	int status = 0;
+	if (!server->start() || !server->serve()) status = 1;
+	delete server;
+	return status;
+}
@@ -0,0 +1,90 @@
+/* snapshot: draws a game of a record file as the game shows it and writes the picture, for looking at
+   games and for checking the renderer without a window */
+
+#include <stdio.h>
+#include <string.h>
+#include "brain.h"
+#include "render.h"
+
+/***********************************************************************************************/
+
+class Snapshot {
+	const char* recordsName;
+	const char* outName;
+	int game;                       // counted from 0
+	int moves;                      // drawn of the game, all if negative
+	bool frameLast;                 // frame the square of the last move
+public:
+	Snapshot();
+	bool parse(int argc, char** argv);
+	bool run();
+};
+
+/***********************************************************************************************/
+
+Snapshot::Snapshot() {
+	recordsName = NULL;
+	outName = NULL;
+	game = 0;
+	moves = -1;
+	frameLast = true;
+}
+
+bool Snapshot::parse(int argc, char** argv) {
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-records")) recordsName = value;
+		else if (!strcmp(arg, "-game")) game = atoi(value);
+		else if (!strcmp(arg, "-moves")) moves = atoi(value);
+		else if (!strcmp(arg, "-frame")) frameLast = atoi(value) != 0;
+		else if (!strcmp(arg, "-out")) outName = value;
+		else return false;
+	}
+	return recordsName && outName && game >= 0;
+}
+
+bool Snapshot::run() {
+	RecordReader reader;
+	if (!reader.open(recordsName)) {
+		printf("%s is not a game record file\n", recordsName);
+		return false;
+	}
+	RecordedGame recorded;
+	for (int g = 0; g <= game; g++)
+		if (!reader.next(&recorded)) {
+			printf("%s holds %d games\n", recordsName, reader.size());
+			return false;
+		}
+	int cols = recorded.header->cols, rows = recorded.header->rows;
+	Renderer* view = new Renderer(cols, rows, cols * SQUARE + 1, rows * SQUARE + 1);
+	MoveCursor cursor(&recorded);
+	int drawn = 0;
+	while ((moves < 0 || drawn < moves) && cursor.next()) {
+		view->drawStone(cursor.i, cursor.j, cursor.player);
+		drawn++;
+	}
+	if (frameLast && drawn) view->frameSquare(cursor.i, cursor.j, FRAMECOL);
+	int length = (int) strlen(outName);
+	bool png = length > 4 && !strcmp(outName + length - 4, ".png");
+	bool written = png ? view->writePNG(outName) : view->writePPM(outName);
+	if (written) printf("game %d after %d moves written to %s\n", game, drawn, outName);
+	else printf("cannot write %s\n", outName);
+	delete view;
+	return written;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Snapshot* snapshot = new Snapshot();
+	if (!snapshot->parse(argc, argv)) {
+		printf("usage: snapshot -records file -out file.ppm|file.png [-game n] [-moves n] [-frame 0|1]\n");
+		delete snapshot;
+		return 1;
+	}
+	int status = snapshot->run() ? 0 : 1;
+	delete snapshot;
+	return status;
+}
@@ -0,0 +1,147 @@
+/* solve: decides positions by proof-number search, for checking puzzles and endgames; every position is
+   reported as won, lost or drawn for the player to move together with the winning line. The attacker plays
+   the cells near the stones and the defender every cell, so a win holds against any defence; a draw is
+   only claimed when no attack was left out, else neither side winning by moves near the stones is reported
+   as such */
+
+#include <stdio.h>
+#include <string.h>
+#include "brain.h"
+
+/***********************************************************************************************/
+
+class Solver {
+	int cols;
+	int rows;
+	unsigned long long nodes;       // per position and side
+	int moveTime;                   // ms per position and side, 0 for no limit
+	int memory;                     // MB of the node table
+	const char* positionsName;
+	/* one position per line, "i,j,item" for every stone (CIRCLE 1, CROSS 2), optionally followed by the
+	   expected result for the player to move: win, loss or draw; the player to move is the one with fewer
+	   stones, a cross if both have as many */
+	template<int numCols, int numRows> int solveAll(FILE* f);
+public:
+	Solver();
+	bool parse(int argc, char** argv);
+	int run();                      // the number of positions decided differently than expected, -1 without a file
+};
+
+/***********************************************************************************************/
+
+Solver::Solver() {
+	cols = NUMCOLS;
+	rows = NUMROWS;
+	nodes = 10000000;
+	moveTime = 0;
+	memory = 256;
+	positionsName = NULL;
+}
+
+bool Solver::parse(int argc, char** argv) {
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-positions")) positionsName = value;
+		else if (!strcmp(arg, "-nodes")) nodes = strtoull(value, NULL, 10);
+		else if (!strcmp(arg, "-time")) moveTime = atoi(value);
+		else if (!strcmp(arg, "-memory")) memory = atoi(value) > 0 ? atoi(value) : 1;
+		else if (!strcmp(arg, "-size")) cols = rows = atoi(value);
+		else return false;
+	}
+	if (cols != 15 && cols != 19 && cols != NUMCOLS) return false;  // the boards of the library
+	return positionsName != NULL;
+}
+
+template<int numCols, int numRows>
+int Solver::solveAll(FILE* f) {
+	static const char* names[3] = {"loss", "draw", "win"};
+	BasicField<numCols, numRows>* field = new BasicField<numCols, numRows>();
+	BasicBrain<numCols, numRows>* brain = new BasicBrain<numCols, numRows>(field, 1);  // only the proof table is used
+	brain->setThreads(1);
+	brain->setSolver(0, BasicProofSearch<numCols, numRows>::sizeFor(memory * 1048576LL));
+	int numPositions = 0, solved = 0, nearDraws = 0, wrong = 0;
+	unsigned long long totalNodes = 0;
+	long long totalTime = 0;
+	char line[16384];
+	while (fgets(line, sizeof(line), f)) {
+		int count[3] = {0, 0, 0};
+		for (int i = 0; i < numCols; i++)
+			for (int j = 0; j < numRows; j++)
+				field->set(i, j, 0);
+		const char* s = line;
+		int i, j, item, n;
+		while (sscanf(s, "%d,%d,%d%n", &i, &j, &item, &n) == 3) {
+			if (i < 0 || i >= numCols || j < 0 || j >= numRows || (item != CIRCLE && item != CROSS)) break;
+			field->set(i, j, item);
+			count[item]++;
+			s += n;
+		}
+		if (!field->stones) continue;
+		int expected = 2;           // 1 win, -1 loss, 0 draw, 2 not given
+		char word[16];
+		if (sscanf(s, "%15s", word) == 1) {
+			if (!strcmp(word, "win")) expected = 1;
+			else if (!strcmp(word, "loss")) expected = -1;
+			else if (!strcmp(word, "draw")) expected = 0;
+		}
+		numPositions++;
+		int player = count[CROSS] > count[CIRCLE] ? CIRCLE : CROSS;
+		ProofInfo info;
+		brain->solve(player, nodes, moveTime, &info);
+		totalNodes += info.nodes;
+		totalTime += info.time;
+		int result = 2;             // not decided
+		if (info.result == PROOFDRAW) result = 0;
+		else if (info.result == CIRCLE || info.result == CROSS) result = info.result == player ? 1 : -1;
+		if (result != 2) solved++;
+		else if (info.result == PROOFNOWINNEAR) nearDraws++;
+		printf("%d: %s", numPositions, result != 2 ? names[result + 1] :
+			info.result == PROOFNOWINNEAR ? "no win near the stones" : "unknown");
+		if (info.length) {
+			printf(" in %d plies,", info.length);
+			for (int m = 0; m < info.length; m++)
+				printf(" %d,%d", info.line[m].i, info.line[m].j);
+		}
+		printf(", %llu nodes, %d ms", info.nodes, info.time);
+		if (expected != 2 && result != expected) {
+			printf(", expected %s", names[expected + 1]);
+			wrong++;
+		}
+		printf("\n");
+	}
+	printf("solved %d of %d positions, %d without a win near the stones, %d differ from the expected result, "
+		"%llu nodes, %lld ms\n", solved, numPositions, nearDraws, wrong, totalNodes, totalTime);
+	delete brain;
+	delete field;
+	return wrong;
+}
+
+int Solver::run() {
+	FILE* f = fopen(positionsName, "r");
+	if (!f) {
+		printf("cannot read %s\n", positionsName);
+		return -1;
+	}
+	int wrong;
+	if (cols == 15) wrong = solveAll<15, 15>(f);
+	else if (cols == 19) wrong = solveAll<19, 19>(f);
+	else wrong = solveAll<NUMCOLS, NUMROWS>(f);
+	fclose(f);
+	return wrong;
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Solver* solver = new Solver();
+	if (!solver->parse(argc, argv)) {
+		printf("usage: solve -positions file [-nodes n] [-time ms] [-memory mb] [-size 15|19|20]\n");
+		delete solver;
+		return 1;
+	}
+	int wrong = solver->run();
+	delete solver;
+	return wrong ? 1 : 0;
+}
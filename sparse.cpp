@@ -0,0 +1,436 @@
+#include <string.h>
+#include <algorithm>
+#include "sparse.h"
+
+static const int dirI[4] = {1, 0, 1, -1};  // the directions of Field::lineDirection
+static const int dirJ[4] = {0, 1, 1, 1};
+
+/* slot of i,j in a table of mask + 1 slots */
+inline int slotOf(int i, int j, int mask) {
+	unsigned long long x = ((unsigned long long) (unsigned) i << 32 | (unsigned) j) * 0x9e3779b97f4a7c15ULL;
+	return (int) (x >> 40) & mask;
+}
+
+/***********************************************************************************************/
+
+SparseField::SparseField(int cols, int rows) {
+	this->cols = cols;
+	this->rows = rows;
+	slots.resize(MINSLOTS);
+	for (int s = 0; s < MINSLOTS; s++)
+		slots[s].used = false;
+	usedSlots = 0;
+	stones = 0;
+}
+
+bool SparseField::inside(int i, int j) const {
+	return (!cols || (i >= 0 && i < cols)) && (!rows || (j >= 0 && j < rows));
+}
+
+int SparseField::findSlot(int i, int j) const {
+	int mask = (int) slots.size() - 1;
+	int s = slotOf(i, j, mask);
+	while (slots[s].used && (slots[s].i != i || slots[s].j != j))
+		s = (s + 1) & mask;
+	return s;
+}
+
+SparseField::Slot* SparseField::addSlot(int i, int j) {
+	if (2 * (usedSlots + 1) > (int) slots.size()) {
+		std::vector<Slot> old;
+		old.swap(slots);
+		slots.resize(2 * old.size());
+		for (size_t s = 0; s < slots.size(); s++)
+			slots[s].used = false;
+		for (size_t s = 0; s < old.size(); s++)
+			if (old[s].used) slots[findSlot(old[s].i, old[s].j)] = old[s];
+	}
+	Slot* slot = &slots[findSlot(i, j)];
+	slot->i = i;
+	slot->j = j;
+	slot->used = true;
+	slot->item = 0;
+	slot->neighbours = 0;
+	slot->frontierIndex = -1;
+	usedSlots++;
+	return slot;
+}
+
+void SparseField::removeSlot(int s) {
+	int mask = (int) slots.size() - 1;
+	slots[s].used = false;
+	usedSlots--;
+	// move back the slots of the same run which could not take their own place, so that no search stops early
+	for (int k = (s + 1) & mask; slots[k].used; k = (k + 1) & mask) {
+		int home = slotOf(slots[k].i, slots[k].j, mask);
+		if (((k - home) & mask) >= ((k - s) & mask)) {
+			slots[s] = slots[k];
+			slots[k].used = false;
+			s = k;
+		}
+	}
+}
+
+void SparseField::addFrontier(Slot* slot) {
+	Cell cell;
+	cell.i = slot->i;
+	cell.j = slot->j;
+	slot->frontierIndex = (int) frontier.size();
+	frontier.push_back(cell);
+}
+
+void SparseField::removeFrontier(Slot* slot) {
+	Cell last = frontier.back();
+	int index = slot->frontierIndex;
+	slots[findSlot(last.i, last.j)].frontierIndex = index;
+	frontier[index] = last;
+	frontier.pop_back();
+	slot->frontierIndex = -1;
+}
+
+int SparseField::at(int i, int j) const {
+	const Slot* slot = &slots[findSlot(i, j)];
+	return slot->used ? slot->item : 0;
+}
+
+void SparseField::set(int i, int j, int item) {
+	if (!inside(i, j)) return;
+	int s = findSlot(i, j);
+	int old = slots[s].used ? slots[s].item : 0;
+	if ((old == 0) == (item == 0)) {  // no stone added or removed
+		if (old) slots[s].item = item;
+		return;
+	}
+	if (item) {
+		Slot* slot = slots[s].used ? &slots[s] : addSlot(i, j);
+		slot->item = item;
+		stones++;
+		if (slot->frontierIndex >= 0) removeFrontier(slot);
+		for (int ii = i - 1; ii <= i + 1; ii++)
+			for (int jj = j - 1; jj <= j + 1; jj++) {
+				if ((ii == i && jj == j) || !inside(ii, jj)) continue;
+				int n = findSlot(ii, jj);
+				Slot* neighbour = slots[n].used ? &slots[n] : addSlot(ii, jj);
+				// an empty cell enters the frontier with its first neighbour
+				if (++neighbour->neighbours == 1 && !neighbour->item) addFrontier(neighbour);
+			}
+	} else {
+		Slot* slot = &slots[s];
+		slot->item = 0;
+		stones--;
+		if (slot->neighbours) addFrontier(slot);
+		for (int ii = i - 1; ii <= i + 1; ii++)
+			for (int jj = j - 1; jj <= j + 1; jj++) {
+				if ((ii == i && jj == j) || !inside(ii, jj)) continue;
+				int n = findSlot(ii, jj);
+				// and leaves it with the last one, its slot is not needed any more
+				if (--slots[n].neighbours == 0 && !slots[n].item) {
+					removeFrontier(&slots[n]);
+					removeSlot(n);
+				}
+			}
+		s = findSlot(i, j);         // the removals may have moved it
+		if (!slots[s].neighbours) removeSlot(s);
+	}
+}
+
+bool SparseField::isFrontier(int i, int j) const {
+	const Slot* slot = &slots[findSlot(i, j)];
+	return slot->used && slot->frontierIndex >= 0;
+}
+
+bool rasterOrder(const Cell& a, const Cell& b) {
+	return a.i < b.i || (a.i == b.i && a.j < b.j);
+}
+
+void SparseField::getStones(std::vector<Cell>* cells) const {
+	cells->clear();
+	for (size_t s = 0; s < slots.size(); s++)
+		if (slots[s].used && slots[s].item) {
+			Cell cell;
+			cell.i = slots[s].i;
+			cell.j = slots[s].j;
+			cells->push_back(cell);
+		}
+	std::sort(cells->begin(), cells->end(), rasterOrder);
+}
+
+bool SparseField::isFive(int player, int i, int j, int* vi, int* vj, int* direction) const {
+	for (int d = 0; d < 4; d++) {
+		int back = 0;
+		while (back < 4 && at(i - (back + 1)*dirI[d], j - (back + 1)*dirJ[d]) == player)
+			back++;
+		int run = back + 1;
+		while (run < 5 && at(i + (run - back)*dirI[d], j + (run - back)*dirJ[d]) == player)
+			run++;
+		if (run < 5) continue;
+		if (vi) *vi = i - back*dirI[d];
+		if (vj) *vj = j - back*dirJ[d];
+		if (direction) *direction = d + 1;
+		return true;
+	}
+	return false;
+}
+
+/***********************************************************************************************/
+
+SparseBrain::SparseBrain(SparseField* field, int transSize) {
+	this->field = field;
+	transTable = new TransTable(transSize);
+	setSeed((unsigned long long) time(NULL));
+	noise = ROOTNOISE;
+	nodeLimit = 0;
+	nodes = 0;
+	bestI = -1;
+	bestJ = -1;
+	bestPrice = 0;
+	completedDepth = 0;
+}
+
+SparseBrain::~SparseBrain() {
+	delete transTable;
+}
+
+void SparseBrain::setSeed(unsigned long long seed) {
+	this->seed = splitMix64(&seed);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			zobristTurn[i][j] = splitMix64(&seed);
+	transTable->clear();
+}
+
+void SparseBrain::setNoise(int amount) {
+	noise = amount > 0 ? amount : 0;
+}
+
+void SparseBrain::setNodeLimit(unsigned long long nodes) {
+	nodeLimit = nodes;
+}
+
+bool SparseBrain::setWeights(const char* fileName) {
+	return evaluation.load(fileName);
+}
+
+void SparseBrain::initTransTable() {
+	transTable->clear();
+}
+
+bool SparseBrain::isVictory(int player, int i, int j, int* vi, int* vj, int* direction) {
+	return field->isFive(player, i, j, vi, vj, direction);
+}
+
+long long SparseBrain::now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long long SparseBrain::code(int i, int j, int item) {
+	// the codes are computed instead of looked up, there is no table for a field without bounds
+	unsigned long long state = seed ^ (((unsigned long long) (unsigned) i << 32 | (unsigned) j) << 2 | item);
+	return splitMix64(&state);
+}
+
+/* as BasicSearcher::rootNoise, zobristKey has to be that of the root */
+int SparseBrain::rootNoise(int i, int j, int alpha, int beta) {
+	return noiseBonus(zobristKey ^ code(i, j, rootPlayer), noise, alpha, beta);
+}
+
+void SparseBrain::scoreAround(int i, int j, int* score) {
+	int before = evaluation.maxBlockLength - 1;  // windows starting this many cells before [i,j] still hold it
+	for (int d = 0; d < 4; d++) {
+		// read the cells once, the windows overlap
+		int items[2*BLOCKWINDOW];
+		for (int k = 0; k < before + BLOCKWINDOW; k++) {
+			int ii = i + (k - before)*dirI[d];
+			int jj = j + (k - before)*dirJ[d];
+			items[k] = board.inside(ii, jj) ? board.at(ii, jj) : 3;
+		}
+		for (int s = 0; s <= before; s++) {
+			if (items[s] == 3) continue;  // the window starts off the field
+			int code = 0;
+			for (int l = BLOCKWINDOW - 1; l >= 0; l--)
+				code = (code << 2) | items[s + l];
+			score[CIRCLE] += evaluation.blockTable[code][CIRCLE];
+			score[CROSS] += evaluation.blockTable[code][CROSS];
+		}
+	}
+}
+
+void SparseBrain::makeMove(int i, int j, int player) {
+	int delta[3] = {0, 0, 0};
+	scoreAround(i, j, delta);
+	totalScore[CIRCLE] -= delta[CIRCLE];
+	totalScore[CROSS] -= delta[CROSS];
+	board.set(i, j, player);
+	delta[CIRCLE] = delta[CROSS] = 0;
+	scoreAround(i, j, delta);
+	totalScore[CIRCLE] += delta[CIRCLE];
+	totalScore[CROSS] += delta[CROSS];
+	zobristKey ^= code(i, j, player);
+}
+
+void SparseBrain::unmakeMove(int i, int j, int player) {
+	int delta[3] = {0, 0, 0};
+	scoreAround(i, j, delta);
+	totalScore[CIRCLE] -= delta[CIRCLE];
+	totalScore[CROSS] -= delta[CROSS];
+	board.set(i, j, 0);
+	delta[CIRCLE] = delta[CROSS] = 0;
+	scoreAround(i, j, delta);
+	totalScore[CIRCLE] += delta[CIRCLE];
+	totalScore[CROSS] += delta[CROSS];
+	zobristKey ^= code(i, j, player);
+}
+
+int SparseBrain::threatScore(int player, int i, int j) {
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	int result = 0;
+	for (int d = 0; d < 4; d++) {
+		// length of the runs of stones of the same colour touching [i,j] from both sides
+		int runs[3] = {0, 0, 0};
+		int item = board.at(i - dirI[d], j - dirJ[d]);
+		for (int k = 1; item && k <= 4 && board.at(i - k*dirI[d], j - k*dirJ[d]) == item; k++)
+			runs[item]++;
+		int item2 = board.at(i + dirI[d], j + dirJ[d]);
+		int run = 0;
+		for (int k = 1; item2 && k <= 4 && board.at(i + k*dirI[d], j + k*dirJ[d]) == item2; k++)
+			run++;
+		runs[item2] = (item2 == item) ? (runs[item2] + run > 4 ? 4 : runs[item2] + run) : run;
+		result += runScore(runs[player], runs[opponent]);
+	}
+	return result;
+}
+
+int SparseBrain::generateMoves(int player, int depth) {
+	std::vector<Move>& list = moves[depth];
+	int n = (int) board.frontier.size();
+	list.resize(n);
+	for (int k = 0; k < n; k++) {
+		list[k].i = board.frontier[k].i;
+		list[k].j = board.frontier[k].j;
+		list[k].score = threatScore(player, list[k].i, list[k].j);
+	}
+	// ties in raster order, the rank of a move is stored in the transposition table instead of the move
+	std::sort(list.begin(), list.end(), betterMove);
+	return n;
+}
+
+bool SparseBrain::betterMove(const Move& a, const Move& b) {
+	if (a.score != b.score) return a.score > b.score;
+	return a.i < b.i || (a.i == b.i && a.j < b.j);
+}
+
+int SparseBrain::pvs(int player, int depth, int maxDepth, int alpha, int beta) {
+	nodes++;
+	int opponent = (player == CIRCLE) ? CROSS : CIRCLE;
+	bool pvNode = beta - alpha > 1;
+	unsigned long long key = zobristKey ^ zobristTurn[rootPlayer][player];
+	TransTable::Entry entry;
+	bool found = transTable->probe(key, &entry);
+	if (found && depth > 0 && !pvNode && entry.depth >= maxDepth - depth) {
+		int value = entry.value;    // won positions are stored with their distance from the node
+		if (value > WINSCORE - 1000) value -= depth;
+		else if (value < -WINSCORE + 1000) value += depth;
+		int bound = entry.flags & 3;
+		if (bound == EXACT) return value;
+		if (bound == LOWERBOUND && value >= beta) return value;
+		if (bound == UPPERBOUND && value <= alpha) return value;
+	}
+	if (depth == maxDepth) {
+		int result = totalScore[rootPlayer];  // the blocks are valued by the root player
+		if (player != rootPlayer) result = -result;
+		transTable->store(key, 0, EXACT, result, -1);
+		return result;
+	}
+	if (maxDepth > 1 && ((deadline && now() >= deadline) || (nodeLimit && nodes >= nodeLimit))) {
+		timeout = true;
+		return 0;
+	}
+	int origAlpha = alpha;
+	int numMoves = generateMoves(player, depth);
+	std::vector<Move>& list = moves[depth];
+	int hashMove = (found && entry.move >= 0 && entry.move < numMoves) ? entry.move : -1;
+	int best = numMoves ? -INFSCORE : 0;
+	int bestRank = -1;
+	for (int m = 0; m < numMoves && alpha < beta; m++) {
+		// the hash move first, then the others in their order
+		int rank = (hashMove < 0) ? m : (m == 0 ? hashMove : (m <= hashMove ? m - 1 : m));
+		int ii = list[rank].i;
+		int jj = list[rank].j;
+		int price;
+		int bonus = depth ? 0 : rootNoise(ii, jj, alpha, beta);
+		makeMove(ii, jj, player);
+		if (board.isFive(player, ii, jj, NULL, NULL, NULL))  // decided, no need to search any further
+			price = WINSCORE - depth;
+		else {
+			if (m == 0)
+				price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - beta, bonus - alpha);
+			else {
+				price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - alpha - 1, bonus - alpha);
+				if (!timeout && price > alpha && price < beta)
+					price = bonus - pvs(opponent, depth + 1, maxDepth, bonus - beta, bonus - alpha);
+			}
+			if (price > WINSCORE - 1000 || price < -WINSCORE + 1000) price -= bonus;
+		}
+		unmakeMove(ii, jj, player);
+		if (timeout) return 0;
+		if (price > best) {
+			best = price;
+			bestRank = rank;
+		}
+		if (price > alpha) {
+			alpha = price;
+			if (depth == 0) {
+				bestPrice = price;
+				bestI = ii;
+				bestJ = jj;
+			}
+		}
+	}
+	int bound = EXACT;
+	if (best <= origAlpha)
+		bound = UPPERBOUND;
+	else if (best >= beta)
+		bound = LOWERBOUND;
+	int value = best;
+	if (value > WINSCORE - 1000) value += depth;
+	else if (value < -WINSCORE + 1000) value -= depth;
+	transTable->store(key, maxDepth - depth, bound, value, bestRank);
+	return best;
+}
+
+void SparseBrain::getBestMove(int player, int moveTime, int* i, int* j, int maxDepth) {
+	// build the copy stone by stone, so that the pay-off and the key are summed over the stones only
+	std::vector<Cell> stones;
+	std::vector<int> items;
+	field->getStones(&stones);
+	board = SparseField(field->cols, field->rows);
+	totalScore[CIRCLE] = totalScore[CROSS] = 0;
+	zobristKey = 0;
+	for (size_t k = 0; k < stones.size(); k++)
+		items.push_back(field->at(stones[k].i, stones[k].j));
+	for (size_t k = 0; k < stones.size(); k++)
+		makeMove(stones[k].i, stones[k].j, items[k]);
+	rootPlayer = player;
+	deadline = moveTime > 0 ? now() + moveTime * 1000LL : 0;
+	nodes = 0;
+	timeout = false;
+	completedDepth = 0;
+	bestPrice = -INFSCORE;
+	bestI = field->cols / 2;
+	bestJ = field->rows / 2;        // the middle of an empty field
+	transTable->newSearch();
+	if (board.frontier.empty()) {
+		*i = bestI;
+		*j = bestJ;
+		return;
+	}
+	if (maxDepth > MAXDEPTH) maxDepth = MAXDEPTH;
+	for (int d = 1; d <= maxDepth && (d == 1 || !deadline || now() < deadline); d++) {
+		int value = pvs(player, 0, d, -INFSCORE, INFSCORE);
+		if (timeout) break;
+		completedDepth = d;
+		if (value > WINSCORE - 1000 || value < -WINSCORE + 1000) break;  // decided
+	}
+	*i = bestI;
+	*j = bestJ;
+}
@@ -0,0 +1,100 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+/* a board without fixed bounds for the large-board variant: only the stones and the empty cells next to
+   them are kept, so the moves, the evaluation and the hashing cost in proportion to the stones, not to the area */
+
+#include <vector>
+#include "brain.h"
+
+#define MINSLOTS 256                // initial size of the hash table of SparseField
+
+/***********************************************************************************************/
+
+class SparseField {                 // the stones and their empty neighbours in a hash table keyed by the coordinates
+	struct Slot {
+		int i;
+		int j;
+		bool used;
+		unsigned char item;
+		unsigned char neighbours;   // number of occupied cells around i,j
+		int frontierIndex;          // position of i,j in frontier, -1 if it is not there
+	};
+	/* open addressing with linear probing, a power of two in size and at most half full;
+	   a slot is freed once its cell is empty and has no occupied neighbour */
+	std::vector<Slot> slots;
+	int usedSlots;
+	int findSlot(int i, int j) const;   // the slot holding i,j or the free one where it belongs
+	Slot* addSlot(int i, int j);
+	void removeSlot(int s);
+	void addFrontier(Slot* slot);
+	void removeFrontier(Slot* slot);
+public:
+	int cols;
+	int rows;                       // the bounds of the field, 0 for none
+	int stones;                     // number of occupied cells
+	std::vector<Cell> frontier;     // empty cells with an occupied neighbour in no particular order
+	SparseField(int cols = 0, int rows = 0);
+	bool inside(int i, int j) const;
+	int at(int i, int j) const;     // returns item on i,j (0 outside of the field)
+	void set(int i, int j, int item);
+	bool isFrontier(int i, int j) const;
+	void getStones(std::vector<Cell>* cells) const;  // the occupied cells in raster order
+	/* check five stones of player passing through [i,j], return where they start and their direction */
+	bool isFive(int player, int i, int j, int* vi, int* vj, int* direction) const;
+};
+
+/***********************************************************************************************/
+
+class SparseBrain {                 // searches the best move on a SparseField in the calling thread
+	struct Move {
+		int i;
+		int j;
+		int score;
+	};
+	SparseField* field;
+	SparseField board;          // the copy of field being searched
+	Evaluation evaluation;
+	TransTable* transTable;
+	unsigned long long seed;    // of the zobrist codes
+	int noise;                  // range of the random bonus of the root moves
+	unsigned long long zobristTurn[3][3];  // codes for the root player and the player to move
+	unsigned long long zobristKey;
+	int totalScore[3];          // pay-off of all windows holding a stone for CIRCLE and CROSS
+	int rootPlayer;
+	long long deadline;
+	unsigned long long nodeLimit;
+	bool timeout;
+	std::vector<Move> moves[MAXDEPTH+1];  // the moves of each depth, kept to save the allocations
+	unsigned long long code(int i, int j, int item);  // zobrist code of item on i,j
+	int rootNoise(int i, int j, int alpha, int beta);
+	void scoreAround(int i, int j, int* score);  // add the pay-off of the windows holding [i,j] to score
+	void makeMove(int i, int j, int player);
+	void unmakeMove(int i, int j, int player);
+	int threatScore(int player, int i, int j);  // cheap estimate of how good [i,j] is for player
+	/* fills moves[depth], most promising first by threatScore alone, there are no killers or history as in
+	   BasicSearcher */
+	int generateMoves(int player, int depth);
+	static bool betterMove(const Move& a, const Move& b);
+	int pvs(int player, int depth, int maxDepth, int alpha, int beta);
+	static long long now();     // us of the steady clock
+public:
+	int bestI;
+	int bestJ;
+	int bestPrice;
+	int completedDepth;
+	unsigned long long nodes;
+	SparseBrain(SparseField* field, int transSize = TRANSSIZE);
+	~SparseBrain();
+	void setSeed(unsigned long long seed);  // the zobrist codes and the random choice among the root moves
+	void setNoise(int amount);  // see Brain::setNoise
+	void setNodeLimit(unsigned long long nodes);  // stop the next searches after nodes, 0 for no limit
+	bool setWeights(const char* fileName);  // the values of the blocks written by the tuner, see Evaluation::load
+	/* return the best move for player found within moveTime ms (no limit if 0), searching at most maxDepth */
+	void getBestMove(int player, int moveTime, int* i, int* j, int maxDepth = MAXDEPTH);
+	/* check a victory for player passing through his last move [i,j] */
+	bool isVictory(int player, int i, int j, int* vi, int* vj, int* direction);
+	void initTransTable();      // forget everything learnt in the previous games
+};
+
+#endif
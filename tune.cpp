@@ -0,0 +1,362 @@
+/* tune: fits the values of the blocks to the results of recorded games by logistic regression (Texel's method)
+   on all cores and writes them for Brain::setWeights */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "brain.h"
+
+#define MAXGAMELENGTH (NUMCOLS*NUMROWS)
+#define MAXCOUNT 2047               // the most windows of one block counted in a position, 11 bits
+#define TUNEEPOCHS 300
+#define TUNERATE 0.01               // largest change of a value by one step, relative to its size
+#define MINSCALE 100                // size of the values close to zero
+
+/***********************************************************************************************/
+
+/* the blocks of a position are counted once, the value is then the sum of the values of the blocks times their
+   counts, seen by the player to move; a sample keeps the counts which are not zero and the result of the game */
+struct Samples {
+	std::vector<unsigned char> results;  // 0 lost, 1 drawn, 2 won by the player to move
+	std::vector<unsigned> start;    // first feature of each sample, one more entry for the end
+	std::vector<unsigned short> features;  // block << 11 | count
+	Samples() { start.push_back(0); }
+};
+
+/***********************************************************************************************/
+
+class Tuner {
+	Evaluation evaluation;
+	unsigned blockMask[1 << (2*BLOCKWINDOW)][3];  // bit k is set if block k starts at the window for player
+	std::vector<std::string> games;
+	int workers;
+	int epochs;
+	int skip;                       // the first moves of every game are left out
+	Samples samples;
+	std::mutex lock;                // guards samples while the workers add theirs
+	std::atomic<int> nextGame;
+	double scale;                   // K of the sigmoid 1/(1+exp(-K*value))
+	double weights[NUMBLOCKS];
+	void countLine(Field* field, int line, int from, int to, int sign, int (*counts)[NUMBLOCKS]);
+	void place(Field* field, int i, int j, int player, int (*counts)[NUMBLOCKS]);
+	void extract();                 // the body of a worker turning games into samples
+	/* the mean squared error of the samples from..to and its gradient, added to *error and gradient */
+	void errorRange(int from, int to, double* error, double* gradient);
+	double meanError(double* gradient);  // over all samples on all workers, gradient may be NULL
+public:
+	Tuner();
+	bool parse(int argc, char** argv);
+	bool loadRecords(const char* fileName);
+	void extractSamples();
+	void fitScale();
+	void tune();
+	bool write(const char* fileName);
+};
+
+/***********************************************************************************************/
+
+Tuner::Tuner() {
+	for (int code = 0; code < (1 << (2*BLOCKWINDOW)); code++)
+		for (int player = CIRCLE; player <= CROSS; player++) {
+			blockMask[code][player] = 0;
+			for (int k = 0; k < NUMBLOCKS; k++)
+				if (evaluation.matches(k, code, player)) blockMask[code][player] |= 1u << k;
+		}
+	workers = std::thread::hardware_concurrency();
+	if (workers < 1) workers = 1;
+	epochs = TUNEEPOCHS;
+	skip = 2;
+	scale = 0;
+}
+
+bool Tuner::parse(int argc, char** argv) {
+	bool output = false;
+	if (argc % 2 == 0) return false;   // every option has a value
+	for (int k = 1; k + 1 < argc; k += 2) {
+		const char* arg = argv[k];
+		const char* value = argv[k + 1];
+		if (!strcmp(arg, "-records")) {
+			if (!loadRecords(value)) {
+				printf("cannot read %s\n", value);
+				return false;
+			}
+		} else if (!strcmp(arg, "-weights")) {   // start from other values than the built-in ones
+			if (!evaluation.load(value)) {
+				printf("cannot read %s\n", value);
+				return false;
+			}
+		} else if (!strcmp(arg, "-workers")) workers = atoi(value) > 0 ? atoi(value) : 1;
+		else if (!strcmp(arg, "-epochs")) epochs = atoi(value);
+		else if (!strcmp(arg, "-skip")) skip = atoi(value);
+		else if (!strcmp(arg, "-out")) output = true;
+		else return false;
+	}
+	return output && !games.empty() && epochs >= 0;
+}
+
+/* one game per line, "i,j" for every stone, a cross first, as read by bookgen; the finished games of a game
+   record file played on this board and begun by a cross are turned into such lines */
+bool Tuner::loadRecords(const char* fileName) {
+	RecordReader reader;
+	if (reader.open(fileName)) {
+		RecordedGame recorded;
+		int loaded = 0;
+		while (reader.next(&recorded)) {
+			const RecordHeader* header = recorded.header;
+			if (header->cols != NUMCOLS || header->rows != NUMROWS || !header->result || (header->flags & RECORDCIRCLEFIRST))
+				continue;
+			std::string line;
+			MoveCursor cursor(&recorded);
+			while (cursor.next()) {
+				char move[16];
+				sprintf(move, "%d,%d ", cursor.i, cursor.j);
+				line += move;
+			}
+			games.push_back(line);
+			loaded++;
+		}
+		printf("%d of %d games read from %s\n", loaded, reader.size(), fileName);
+		return true;
+	}
+	FILE* f = fopen(fileName, "r");
+	if (!f) return false;
+	char line[8192];
+	int loaded = 0;
+	while (fgets(line, sizeof(line), f)) {
+		games.push_back(line);
+		loaded++;
+	}
+	fclose(f);
+	printf("%d games read from %s\n", loaded, fileName);
+	return true;
+}
+
+/* add sign times the blocks starting at positions from..to of a line for both players, see BasicSearcher::scoreLine */
+void Tuner::countLine(Field* field, int line, int from, int to, int sign, int (*counts)[NUMBLOCKS]) {
+	int len = Field::lineLength[line];
+	int code = 0;
+	for (int l = BLOCKWINDOW - 1; l >= 0; l--) {
+		int item = (to + l < len) ? field->lineItem(line, to + l) : 3;
+		code = (code << 2) | item;
+	}
+	for (int s = to; ; s--) {
+		for (int player = CIRCLE; player <= CROSS; player++)
+			for (unsigned mask = blockMask[code][player]; mask; mask &= mask - 1) {
+				int k = 0;
+				while (!((mask >> k) & 1)) k++;
+				counts[player][k] += sign;
+			}
+		if (s == from) break;
+		code = ((code << 2) | field->lineItem(line, s - 1)) & ((1 << (2*BLOCKWINDOW)) - 1);
+	}
+}
+
+/* put the stone and count again the windows of the four lines which hold it */
+void Tuner::place(Field* field, int i, int j, int player, int (*counts)[NUMBLOCKS]) {
+	int from[4];
+	for (int d = 0; d < 4; d++) {
+		int pos = Field::linePos[i][j][d];
+		from[d] = pos - evaluation.maxBlockLength + 1 > 0 ? pos - evaluation.maxBlockLength + 1 : 0;
+		countLine(field, Field::lineOf[i][j][d], from[d], pos, -1, counts);
+	}
+	field->set(i, j, player);
+	for (int d = 0; d < 4; d++)
+		countLine(field, Field::lineOf[i][j][d], from[d], Field::linePos[i][j][d], 1, counts);
+}
+
+void Tuner::extract() {
+	Field* field = new Field();
+	Samples own;
+	int moves[MAXGAMELENGTH][2];
+	for (int game = nextGame++; game < (int) games.size(); game = nextGame++) {
+		// the stones up to the one making five, the result is known only then
+		for (int i = 0; i < NUMCOLS; i++)
+			for (int j = 0; j < NUMROWS; j++)
+				field->set(i, j, 0);
+		int length = 0;
+		int winner = 0;
+		int player = CROSS;
+		const char* s = games[game].c_str();
+		int i, j, n;
+		while (!winner && length < MAXGAMELENGTH && sscanf(s, "%d,%d%n", &i, &j, &n) == 2) {
+			if (i < 0 || i >= NUMCOLS || j < 0 || j >= NUMROWS || field->at(i, j)) break;
+			field->set(i, j, player);
+			moves[length][0] = i;
+			moves[length++][1] = j;
+			if (field->isFive(player, i, j, NULL, NULL, NULL)) winner = player;
+			player = (player == CIRCLE) ? CROSS : CIRCLE;
+			s += n;
+		}
+		// replay it, every position before a move is a sample seen by the player making the move
+		for (int i = 0; i < NUMCOLS; i++)
+			for (int j = 0; j < NUMROWS; j++)
+				field->set(i, j, 0);
+		int counts[3][NUMBLOCKS];
+		memset(counts, 0, sizeof(counts));  // every block holds a stone
+		player = CROSS;
+		for (int m = 0; m < length; m++) {
+			if (m >= skip) {
+				own.results.push_back(winner == 0 ? 1 : (winner == player ? 2 : 0));
+				for (int k = 0; k < NUMBLOCKS; k++)
+					if (counts[player][k])
+						own.features.push_back((unsigned short) (k << 11 | (counts[player][k] < MAXCOUNT ? counts[player][k] : MAXCOUNT)));
+				own.start.push_back((unsigned) own.features.size());
+			}
+			place(field, moves[m][0], moves[m][1], player, counts);
+			player = (player == CIRCLE) ? CROSS : CIRCLE;
+		}
+	}
+	delete field;
+	lock.lock();
+	unsigned offset = (unsigned) samples.features.size();
+	samples.results.insert(samples.results.end(), own.results.begin(), own.results.end());
+	samples.features.insert(samples.features.end(), own.features.begin(), own.features.end());
+	for (size_t k = 1; k < own.start.size(); k++)
+		samples.start.push_back(own.start[k] + offset);
+	lock.unlock();
+}
+
+void Tuner::extractSamples() {
+	nextGame = 0;
+	std::thread* threads = new std::thread[workers];
+	for (int w = 0; w < workers; w++)
+		threads[w] = std::thread(&Tuner::extract, this);
+	for (int w = 0; w < workers; w++)
+		threads[w].join();
+	delete[] threads;
+	games.clear();
+	std::vector<std::string>().swap(games);
+	for (int k = 0; k < NUMBLOCKS; k++)
+		weights[k] = evaluation.blocks[k].value;
+	printf("%d positions, %.1f blocks each\n", (int) samples.results.size(),
+		samples.results.empty() ? 0.0 : (double) samples.features.size() / samples.results.size());
+}
+
+void Tuner::errorRange(int from, int to, double* error, double* gradient) {
+	double sum = 0;
+	double g[NUMBLOCKS] = {0};
+	for (int s = from; s < to; s++) {
+		double value = 0;
+		for (unsigned f = samples.start[s]; f < samples.start[s + 1]; f++)
+			value += weights[samples.features[f] >> 11] * (samples.features[f] & MAXCOUNT);
+		double predicted = 1 / (1 + exp(-scale * value));
+		double difference = samples.results[s] * 0.5 - predicted;
+		sum += difference * difference;
+		if (!gradient) continue;
+		double d = -2 * difference * predicted * (1 - predicted) * scale;
+		for (unsigned f = samples.start[s]; f < samples.start[s + 1]; f++)
+			g[samples.features[f] >> 11] += d * (samples.features[f] & MAXCOUNT);
+	}
+	lock.lock();
+	*error += sum;
+	for (int k = 0; gradient && k < NUMBLOCKS; k++)
+		gradient[k] += g[k];
+	lock.unlock();
+}
+
+double Tuner::meanError(double* gradient) {
+	int n = (int) samples.results.size();
+	double error = 0;
+	for (int k = 0; gradient && k < NUMBLOCKS; k++)
+		gradient[k] = 0;
+	std::thread* threads = new std::thread[workers];
+	for (int w = 0; w < workers; w++)
+		threads[w] = std::thread(&Tuner::errorRange, this, (int) ((long long) n * w / workers),
+			(int) ((long long) n * (w + 1) / workers), &error, gradient);
+	for (int w = 0; w < workers; w++)
+		threads[w].join();
+	delete[] threads;
+	for (int k = 0; gradient && k < NUMBLOCKS; k++)
+		gradient[k] /= n;
+	return error / n;
+}
+
+/* the K which makes the present values fit the results best, by golden section search on its logarithm */
+void Tuner::fitScale() {
+	const double ratio = (sqrt(5.0) - 1) / 2;
+	double a = -7, b = -1;          // log10 K
+	double c = b - ratio * (b - a), d = a + ratio * (b - a);
+	scale = pow(10, c);
+	double errorC = meanError(NULL);
+	scale = pow(10, d);
+	double errorD = meanError(NULL);
+	for (int step = 0; step < 40; step++) {
+		if (errorC < errorD) {
+			b = d;
+			d = c;
+			errorD = errorC;
+			c = b - ratio * (b - a);
+			scale = pow(10, c);
+			errorC = meanError(NULL);
+		} else {
+			a = c;
+			c = d;
+			errorC = errorD;
+			d = a + ratio * (b - a);
+			scale = pow(10, d);
+			errorD = meanError(NULL);
+		}
+	}
+	scale = pow(10, (a + b) / 2);
+	printf("K %.3g, error %.6f\n", scale, meanError(NULL));
+}
+
+/* Adam on all values at once; each step moves a value by at most TUNERATE of its starting size */
+void Tuner::tune() {
+	double size[NUMBLOCKS], m[NUMBLOCKS] = {0}, v[NUMBLOCKS] = {0}, gradient[NUMBLOCKS];
+	const double beta1 = 0.9, beta2 = 0.999;
+	for (int k = 0; k < NUMBLOCKS; k++)
+		size[k] = fabs(weights[k]) > MINSCALE ? fabs(weights[k]) : MINSCALE;
+	long long start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		double error = meanError(gradient);
+		for (int k = 0; k < NUMBLOCKS; k++) {
+			m[k] = beta1 * m[k] + (1 - beta1) * gradient[k];
+			v[k] = beta2 * v[k] + (1 - beta2) * gradient[k] * gradient[k];
+			double mHat = m[k] / (1 - pow(beta1, epoch));
+			double vHat = v[k] / (1 - pow(beta2, epoch));
+			weights[k] -= TUNERATE * size[k] * mHat / (sqrt(vHat) + 1e-30);
+		}
+		if (epoch % 25 == 0 || epoch == epochs) {
+			long long now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			printf("epoch %d, error %.6f, %.1f s\n", epoch, error, (now - start) / 1000.0);
+			fflush(stdout);
+		}
+	}
+	printf("error %.6f\n", meanError(NULL));
+}
+
+bool Tuner::write(const char* fileName) {
+	for (int k = 0; k < NUMBLOCKS; k++) {
+		evaluation.blocks[k].value = (int) floor(weights[k] + 0.5);
+		printf("%9d \"%s\"\n", evaluation.blocks[k].value, evaluation.blocks[k].string);
+	}
+	return evaluation.save(fileName);
+}
+
+/***********************************************************************************************/
+
+int main(int argc, char** argv) {
+	Tuner* tuner = new Tuner();
+	if (!tuner->parse(argc, argv)) {
+		printf("usage: tune -records file [-records file ...] -out file [-weights file] [-epochs n] [-skip moves]\n"
+			"            [-workers n]\n");
+		delete tuner;
+		return 1;
+	}
+	tuner->extractSamples();
+	tuner->fitScale();
+	tuner->tune();
+	const char* fileName = NULL;
+	for (int k = 1; k + 1 < argc; k++)
+		if (!strcmp(argv[k], "-out")) fileName = argv[k + 1];
+	int status = 0;
+	if (!tuner->write(fileName)) {
+		printf("cannot write %s\n", fileName);
+		status = 1;
+	}
+	delete tuner;
+	return status;
+}